@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "player_link.h"
+
+// Album art comes in binary player link frames of the player screen, field
+// PlayerInfoId AlbumArtData, type LinkBytes, little endian:
+//   begin  [0][track hash u32][width u8][height u8][format u8][size u32]
+//   chunk  [1][seq u16][data]
+//   clear  [2]                                   the track has no art
+// The display answers every begin and chunk with a frame on the same screen
+// and field: [status u8][track hash u32][next seq u16]. On "have" the art was
+// cached and is shown, nothing is sent. The host keeps at most
+// ALBUM_ART_WINDOW chunks unanswered. A chunk out of sequence is dropped and
+// answered with the seq expected, the host goes back to that one. size is the
+// compressed bytes of all chunks; a transfer that goes past it, or ends there
+// short of the last pixel, is rejected.
+// Format 1 is RLE over RGB565 pixels: a header byte h below 0x80 is followed
+// by h + 1 literal pixels, from 0x80 on by one pixel repeated (h & 0x7F) + 1
+// times.
+#define ALBUM_ART_SIZE 48 // px square, right of the metadata lines
+#define ALBUM_ART_CACHE_SLOTS 3
+#define ALBUM_ART_WINDOW 2      // chunks in flight, two full frames fit the serial ring
+#define ALBUM_ART_CHUNK_MAX 480 // data bytes per chunk the host should send at most
+#define ALBUM_ART_FORMAT_RLE565 1
+
+#define ALBUM_ART_OP_BEGIN 0
+#define ALBUM_ART_OP_CHUNK 1
+#define ALBUM_ART_OP_CLEAR 2
+
+#define ALBUM_ART_STATUS_HAVE 0
+#define ALBUM_ART_STATUS_SEND 1
+#define ALBUM_ART_STATUS_DONE 2
+#define ALBUM_ART_STATUS_REJECTED 3
+
+struct AlbumArtStats
+{
+  uint32_t images;        // decoded to the last pixel
+  uint32_t cacheHits;     // begins answered with "have"
+  uint32_t rejected;      // begins of an unknown size or format, chunks of no transfer, transfers off their declared size
+  uint32_t outOfSequence; // chunks dropped, the host resent from the expected one
+  uint32_t aborted;       // transfers a new begin cut short
+  uint32_t bytesTotal;
+  uint32_t lastBytes;
+  uint32_t lastTransferMs;   // begin to last pixel
+  uint32_t lastDecodeMicros; // of that, time spent expanding chunks
+};
+
+// Expands album art chunk by chunk as frames come off the link, straight
+// into a sprite, so neither the compressed image nor a second bitmap is ever
+// held. Finished images are copied into a small cache keyed by track hash, a
+// repeated track is shown from there without a transfer.
+class AlbumArt
+{
+public:
+  AlbumArt(TFT_eSPI *display);
+
+  bool Begin(Print &out, Print &log); // acks to out, [ART] lines to log; allocates the sprite and the cache
+  bool Handle(const PlayerLinkFrame &frame); // true when the art to show changed
+  TFT_eSprite *Current(); // nullptr when the track has no art
+
+  const AlbumArtStats &Stats();
+
+private:
+  void HandleBegin(const uint8_t *p, uint16_t length);
+  bool HandleChunk(const uint8_t *p, uint16_t length);
+  void Reject();
+  void Expand(const uint8_t *data, uint16_t length);
+  void Put(uint16_t color);
+  bool Finish();
+  int8_t Find(uint32_t hash);
+  void Ack(uint8_t status);
+
+  enum ExpandState : uint8_t
+  {
+    ExpandHeader,
+    ExpandRunLow,
+    ExpandRunHigh,
+    ExpandLiteralLow,
+    ExpandLiteralHigh
+  };
+
+  TFT_eSprite sprite;
+  Print *out = nullptr;
+  Print *logOut = nullptr;
+  int8_t screen = 0;
+  uint8_t field = 0;
+  uint16_t *cache = nullptr; // ALBUM_ART_CACHE_SLOTS bitmaps in sprite byte order
+  uint32_t cacheHashes[ALBUM_ART_CACHE_SLOTS] = {};
+  uint32_t cacheUsed[ALBUM_ART_CACHE_SLOTS] = {}; // last use, 0 = empty
+  uint32_t useCount = 0;
+  bool isShown = false;
+
+  bool isReceiving = false;
+  uint32_t hash = 0;
+  uint16_t nextSeq = 0;
+  uint32_t pixelIndex = 0;
+  uint32_t startMillis = 0;
+  uint32_t size = 0; // declared by the begin
+  uint32_t bytes = 0;
+  uint32_t decodeMicros = 0;
+  ExpandState state = ExpandHeader;
+  uint8_t remaining = 0;
+  uint8_t low = 0;
+  AlbumArtStats stats = {};
+};
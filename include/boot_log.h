@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define BOOT_LOG_MAX_PHASES 8
+#define BOOT_LOG_PENDING UINT32_MAX
+
+// Milliseconds since reset at which each boot phase was first reached,
+// logged as "[BOOT]" lines as they happen. Phases are marked from whichever
+// task reaches them, each by one task only. A phase may carry a budget, going
+// over it is logged and counted.
+class BootLog
+{
+public:
+  void Begin(Print &out, const char *const *phaseNames, uint8_t phaseCount);
+  void SetBudget(uint8_t phase, uint32_t ms);
+  void Mark(uint8_t phase); // first call only
+
+  bool IsMarked(uint8_t phase);
+  uint32_t At(uint8_t phase); // BOOT_LOG_PENDING when not reached yet
+  const char *Name(uint8_t phase);
+  uint8_t PhaseCount();
+  uint8_t OverBudget();
+
+private:
+  Print *out = nullptr;
+  const char *const *phaseNames = nullptr;
+  uint8_t phaseCount = 0;
+  uint32_t atMillis[BOOT_LOG_MAX_PHASES];
+  uint32_t budgetMs[BOOT_LOG_MAX_PHASES];
+  uint8_t overBudget = 0;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+#define COMPOSITOR_MAX_DIRTY_RECTS 16
+#define COMPOSITOR_DMA_BUFFER_PIXELS 2048 // per staging buffer, two of them
+
+struct DirtyRect
+{
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+};
+
+struct CompositorStats
+{
+  uint32_t bytesPushedTotal;
+  uint32_t bytesPushedPerSec; // bytes pushed during the last full second
+  uint32_t rectsPushedTotal;
+  uint32_t flushCount;
+  float framesPerSec;          // flushes that pushed anything, over the last full second
+  uint32_t dmaWaitMicrosTotal; // CPU time blocked on a DMA transfer still running
+  float dmaWaitPercent;        // share of the last full second spent that way
+};
+
+// Widgets draw into a RAM canvas and mark the area they touched as dirty.
+// Overlapping dirty rectangles are merged, and Flush() pushes only the merged
+// regions to the panel, once per frame.
+// With DMA, Flush() copies each region band by band into two staging buffers
+// and streams one while it fills the other. The last band is still going out
+// when Flush() returns, so the next frame is composed during the transfer;
+// the wait happens at the next swap point, or in Sync() before anyone else
+// uses the bus. Build with -D COMPOSITOR_DMA_DISABLE for blocking pushes.
+class Compositor
+{
+public:
+  Compositor(TFT_eSPI &display, TFT_eSprite &canvas);
+
+  bool Begin(uint16_t fillColor);
+  void MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h);
+  void MarkAllDirty();
+  void Clear(uint16_t fillColor);
+  void Blit(TFT_eSprite &src, int32_t x, int32_t y); // 16 bit sprite, plain row copies
+  void BlitWrapped(TFT_eSprite &src, int32_t srcX, int32_t srcY, int32_t x, int32_t y, int32_t w, int32_t h, int32_t wrapWidth = 0); // w x h from (srcX, srcY) on, wrapping after wrapWidth columns (0 = the sprite width)
+  void Flush();
+  void Sync(); // wait for the last transfer and release the bus
+
+  const CompositorStats &Stats();
+
+private:
+  bool ClipRect(DirtyRect &rect);
+  void AddRect(DirtyRect rect);
+  void UpdateRate();
+  void FlushDma();
+  void WaitDma();
+
+  TFT_eSPI &tft;
+  TFT_eSprite &canvas;
+  int16_t width = 0;
+  int16_t height = 0;
+  DirtyRect rects[COMPOSITOR_MAX_DIRTY_RECTS];
+  uint8_t rectCount = 0;
+  CompositorStats stats = {};
+  uint32_t bytesThisSec = 0;
+  uint32_t framesThisSec = 0;
+  uint32_t dmaWaitMicrosThisSec = 0;
+  unsigned long secStartMillis = 0;
+  uint16_t *dmaBuffers[2] = {nullptr, nullptr};
+  uint8_t dmaNext = 0;
+  bool isWriting = false; // bus held since the first band of a DMA flush
+};
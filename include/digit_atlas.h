@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+#define DIGIT_ATLAS_COLON_LIT 10
+#define DIGIT_ATLAS_COLON_GHOST 11
+#define DIGIT_ATLAS_CELLS 12 // 0-9, then the colon lit and unlit
+
+struct DigitAtlasStats
+{
+  uint32_t blits;
+  uint32_t fallbackDraws; // glyphs rasterized because the atlas could not be allocated
+};
+
+// Seven segment digits of a built-in font rasterized once at boot into 1 bit
+// masks, one per digit and one for the colon, about 2 KB for font 7. Drawing
+// a cell expands it row by row into a line buffer and pushes each line: lit
+// where the character has a segment, ghost where only the "8" (or the colon)
+// has one, background elsewhere. No glyph rasterization on the way.
+class DigitAtlas
+{
+public:
+  DigitAtlas(TFT_eSPI *display);
+
+  bool Begin(uint8_t font, uint16_t litColor, uint16_t ghostColor, uint16_t bgColor);
+  int16_t DrawDigit(TFT_eSprite &dst, uint8_t digit, int32_t x, int32_t y);
+  int16_t DrawColon(TFT_eSprite &dst, bool isLit, int32_t x, int32_t y);
+
+  int16_t DigitWidth();
+  int16_t ColonWidth();
+  int16_t Height();
+
+  const DigitAtlasStats &Stats();
+
+private:
+  int16_t DrawCell(TFT_eSprite &dst, uint8_t cell, int32_t x, int32_t y);
+  void RenderMask(TFT_eSprite &scratch, uint8_t mask);
+  char CellChar(uint8_t cell);
+  int16_t CellWidth(uint8_t cell);
+  uint8_t MaskStride(uint8_t mask);
+  uint8_t *Mask(uint8_t mask); // 0-9 the digits, 10 the colon
+
+  TFT_eSPI *display;
+  uint8_t *masks = nullptr;       // rows of MaskStride bytes, msb first
+  uint16_t *linePixels = nullptr; // one expanded row of a cell
+  uint16_t litPixel = 0;          // the colors in sprite byte order
+  uint16_t ghostPixel = 0;
+  uint16_t bgPixel = 0;
+  uint8_t font = 7;
+  uint16_t litColor = TFT_WHITE;
+  uint16_t ghostColor = TFT_DARKGREY;
+  uint16_t bgColor = TFT_BLACK;
+  int16_t digitWidth = 0;
+  int16_t colonWidth = 0;
+  int16_t height = 0;
+  DigitAtlasStats stats = {};
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+#ifndef GLYPH_CACHE_SLOTS
+#define GLYPH_CACHE_SLOTS 64 // max 254
+#endif
+#define GLYPH_CACHE_BUCKETS 64 // power of 2
+
+struct GlyphCacheStats
+{
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint32_t strings;      // strings drawn
+  uint32_t renderMicros; // total time spent drawing those strings
+};
+
+// Keeps one smooth font loaded for the whole uptime and caches glyphs already
+// blended to RGB565 (keyed by codepoint + colors) in an LRU of fixed slots.
+// A cached glyph is a full line-height cell of its advance width, so drawing
+// a string is a sequence of pushImage calls with no font lookups.
+// Build with -D GLYPH_CACHE_DISABLE to measure the loadFont/drawString path.
+class GlyphCache
+{
+public:
+  GlyphCache(TFT_eSPI *display);
+
+  bool Begin(const uint8_t font[]);
+  int16_t DrawString(TFT_eSprite &dst, const char *str, uint16_t length, int32_t x, int32_t y, uint16_t fg, uint16_t bg);
+  int16_t DrawString(TFT_eSprite &dst, const String &str, int32_t x, int32_t y, uint16_t fg, uint16_t bg)
+  {
+    return DrawString(dst, str.c_str(), str.length(), x, y, fg, bg);
+  }
+  int16_t TextWidth(const char *str, uint16_t length);
+  int16_t TextWidth(const String &str)
+  {
+    return TextWidth(str.c_str(), str.length());
+  }
+  int16_t LineHeight();
+
+  const GlyphCacheStats &Stats();
+
+private:
+  struct GlyphEntry
+  {
+    uint16_t code;
+    uint16_t fg;
+    uint16_t bg;
+    uint8_t width;
+    uint8_t lruPrev;
+    uint8_t lruNext;
+    uint8_t hashNext;
+  };
+
+  uint8_t Acquire(uint16_t code, uint16_t fg, uint16_t bg);
+  void Render(uint8_t slot, uint16_t code, uint16_t fg, uint16_t bg);
+  uint8_t GlyphAdvance(uint16_t code);
+  void LruUnlink(uint8_t slot);
+  void LruPushFront(uint8_t slot);
+  void HashRemove(uint8_t slot);
+  uint8_t Bucket(uint16_t code, uint16_t fg, uint16_t bg);
+
+  const uint8_t *fontArray = nullptr;
+  TFT_eSprite fontSource; // holds the loaded font metrics, never allocates pixels
+  uint16_t *pixels = nullptr;
+  uint16_t slotPixels = 0;
+  uint8_t cellHeight = 0;
+  GlyphEntry entries[GLYPH_CACHE_SLOTS];
+  uint8_t buckets[GLYPH_CACHE_BUCKETS];
+  uint8_t lruHead = 0;
+  uint8_t lruTail = 0;
+  uint8_t usedSlots = 0;
+  GlyphCacheStats stats = {};
+};
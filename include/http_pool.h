@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+
+#define HTTP_POOL_HOSTS 4
+#define HTTP_POOL_IDLE_MS 20000    // default, sockets unused this long are closed to give the TLS buffers back
+#define HTTP_LATENCY_BUCKETS 12    // bucket i holds requests up to 16 << i ms, the last one is open
+
+struct HttpHostStats
+{
+  uint32_t requests;
+  uint32_t failures;
+  uint32_t handshakes; // requests that had to open a new connection, with TLS for https
+  uint32_t maxLatencyMs;
+  uint32_t latencyBuckets[HTTP_LATENCY_BUCKETS];
+};
+
+// Response body of a pooled request. Chunked transfer encoding is removed and
+// reads stop at the end of the body, so the socket is left at the next response.
+class HttpBodyStream : public Stream
+{
+public:
+  void Begin(Stream *source, int32_t size, bool isChunked);
+  void Drain();
+  bool IsClean(); // body read up to its end, socket can be reused
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t) override
+  {
+    return 0;
+  }
+
+private:
+  bool Ready();
+  bool NextChunk();
+
+  Stream *source = nullptr;
+  int32_t remaining = 0;  // bytes left in the body or current chunk, -1 = until close
+  bool isChunked = false;
+  bool isChunkStarted = false;
+  bool isDone = true;
+  bool isReusable = false;
+};
+
+// Keeps one connection per scheme and host open between requests (HTTP/1.1
+// keep-alive), so periodic requests skip the TLS handshake. https slots talk
+// TLS, http slots a plain socket. Used by one task only.
+// Get() -> read Body() -> End(), one request at a time.
+class HttpPool
+{
+public:
+  int Get(const String &url, uint32_t idleMs = HTTP_POOL_IDLE_MS); // HTTP code, negative on connection errors; idleMs keeps the socket for the next request
+  Stream &Body();
+  void End();
+
+  uint8_t HostCount();
+  const char *HostName(uint8_t host);
+  const HttpHostStats &Stats(uint8_t host);
+
+private:
+  struct HostSlot
+  {
+    String host; // scheme and host, "https://api.example.com"
+    WiFiClient plainClient;
+    WiFiClientSecure secureClient;
+    WiFiClient *client; // one of the two, by scheme
+    HTTPClient http;
+    unsigned long lastUsedMillis;
+    uint32_t idleMs; // from the last request
+    HttpHostStats stats;
+  };
+
+  uint8_t Acquire(const String &host);
+  void CloseIdle();
+
+  HostSlot slots[HTTP_POOL_HOSTS];
+  uint8_t slotCount = 0;
+  uint8_t current = 0;
+  int currentCode = 0;
+  int64_t startMicros = 0;
+  HttpBodyStream body;
+};
+
+void HttpRecordRequest(HttpHostStats &stats, uint32_t latencyMs, bool isOk); // handshakes are counted by the pool
+// upper bound in ms of the bucket holding the given percentile, capped at the max seen
+uint32_t HttpLatencyPercentile(const HttpHostStats &stats, uint8_t percent);
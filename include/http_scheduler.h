@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define HTTP_SCHEDULER_SLOTS 10 // pending jobs, same depth the old queue had
+#define HTTP_JOB_ALL 255        // index that covers every index of its type
+
+struct HttpJob
+{
+  uint8_t type;           // RequestHttpGetType in main
+  uint8_t index;          // HTTP_JOB_ALL or a type specific index
+  uint8_t priority;       // 0 runs first
+  uint32_t queuedMillis;  // first submit, for the queued time counters
+};
+
+struct HttpSchedulerStats
+{
+  uint32_t submitted;
+  uint32_t coalesced;     // identical to or covered by a pending job
+  uint32_t droppedFull;   // lowest priority job when every slot was taken
+  uint32_t served;
+  uint32_t queuedMsTotal; // of served jobs, submit to start
+  uint32_t queuedMsMax;
+};
+
+// Pending HTTP work between any task and the HTTP task. Submit never blocks:
+// a job equal to or covered by a pending one only raises that job's priority,
+// a full table pushes out its lowest priority job. The HTTP task takes the
+// highest priority job, oldest first.
+class HttpScheduler
+{
+public:
+  void Submit(uint8_t type, uint8_t index, uint8_t priority); // any task
+  bool Take(HttpJob &job, uint32_t timeoutMs); // HTTP task, false when nothing came in time
+
+  uint8_t Pending();
+  HttpSchedulerStats Stats();
+
+private:
+  bool PopBest(HttpJob &job);
+  void RemoveAt(uint8_t slot);
+
+  portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+  TaskHandle_t consumer = nullptr;
+  HttpJob jobs[HTTP_SCHEDULER_SLOTS];
+  uint8_t jobCount = 0;
+  HttpSchedulerStats stats = {};
+};
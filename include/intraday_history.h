@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+#include "watchlist.h"
+
+#define INTRADAY_SESSION_MINUTES 271 // 09:00 to 13:30, the closing auction lands on the last minute
+#define INTRADAY_SCALE 100000        // a tick is the change from the previous close in 1/100000 of it
+
+// One tick per minute and watchlist entry, kept in fixed ring buffers of int16
+// so a whole session costs no allocation. Minutes without a quote repeat the
+// last tick, so neighbouring ticks are always one minute apart. A minute
+// before the newest one starts a new session for that entry.
+class IntradayHistory
+{
+public:
+  void Reset();
+  void Record(uint8_t index, uint16_t minute, float price, float previousClose); // minute since 09:00
+  uint16_t Count(uint8_t index) const;
+  int16_t Tick(uint8_t index, uint16_t age) const; // age 0 = newest, below Count()
+  uint32_t Appended(uint8_t index) const;          // ticks ever appended, tells a drawer how far to shift
+
+private:
+  void Push(uint8_t index, int16_t tick);
+
+  int16_t ticks[WATCHLIST_MAX_SYMBOLS][INTRADAY_SESSION_MINUTES];
+  uint16_t heads[WATCHLIST_MAX_SYMBOLS] = {}; // next slot to write
+  uint16_t counts[WATCHLIST_MAX_SYMBOLS] = {};
+  uint16_t lastMinutes[WATCHLIST_MAX_SYMBOLS] = {};
+  uint32_t appended[WATCHLIST_MAX_SYMBOLS] = {};
+};
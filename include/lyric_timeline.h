@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define LYRIC_TIMELINE_MAX_LINES 192
+#define LYRIC_TIMELINE_BLOB_SIZE 6144
+
+// Whole-song LRC kept on the device: (ms, offset) pairs sorted by time,
+// pointing into one blob of NUL terminated UTF-8 lines. A line with several
+// time tags is stored once.
+class LyricTimeline
+{
+public:
+  void Clear();
+  uint8_t AddLrcLine(const char *data, uint16_t length); // returns number of time tags added
+  int16_t Find(uint32_t positionMs);                     // -1 before the first line
+  uint16_t Count();
+  const char *Line(int16_t index);
+  uint32_t LineMs(int16_t index);
+  uint32_t DroppedLines();
+
+private:
+  struct LyricEntry
+  {
+    uint32_t ms;
+    uint16_t offset;
+  };
+
+  void Insert(uint32_t ms, uint16_t offset);
+
+  LyricEntry entries[LYRIC_TIMELINE_MAX_LINES];
+  uint16_t count = 0;
+  char blob[LYRIC_TIMELINE_BLOB_SIZE];
+  uint16_t blobUsed = 0;
+  uint32_t droppedLines = 0; // did not fit into entries or blob
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "watchlist.h"
+
+#define MARKET_CACHE_VERSION 1
+#define MARKET_CACHE_DESC_SIZE 64
+#define MARKET_CACHE_HEADER (12 + 4 + MARKET_CACHE_DESC_SIZE)
+#define MARKET_CACHE_ENTRY_SIZE (WATCHLIST_SYMBOL_SIZE + 1 + 4 + 4)
+#define MARKET_CACHE_BLOB_MAX (MARKET_CACHE_HEADER + WATCHLIST_MAX_SYMBOLS * MARKET_CACHE_ENTRY_SIZE)
+#define MARKET_CACHE_COMMIT_INTERVAL_MS (10 * 60 * 1000UL) // quotes change every few seconds while TWSE is open
+#define MARKET_CACHE_NVS_BYTES (64 * 1024UL)              // nvs partition in partitions.csv
+#define MARKET_CACHE_ERASE_CYCLES 100000UL                // flash sector endurance
+#define MARKET_CACHE_NVS_ENTRY 32                         // NVS writes in 32 byte entries
+#define MARKET_CACHE_LEGACY_DATE_KEY "c_date"             // before the blob: "c_<index>", "c_y_<index>" and this
+#define MARKET_CACHE_LEGACY_FIRST 3                       // index of JPY, USD follows
+#define MARKET_CACHE_LEGACY_COUNT 2
+
+struct MarketCacheStats
+{
+  uint32_t lifetimeWrites; // kept in the blob, survives reboots
+  uint32_t writes;         // since boot
+  uint32_t bytesWritten;   // since boot, rounded up to NVS entries
+  uint32_t merged;         // changes staged while an earlier one was still uncommitted, writes saved
+};
+
+// Last known prices, currency update date and weather, so a reboot shows data
+// before the first HTTP answer. Staging only touches RAM and notes whether
+// anything changed; Commit writes everything as one packed blob:
+//   [version u8][count u8][humidity i16][writes u32][currency date u32][temp f32][desc]
+//   symbols[count] types[count] prices[count] f32 yesterdayPrices[count] f32
+// Stats belong to the task that commits, other tasks read a copy published
+// with Snapshot.
+class MarketCache
+{
+public:
+  bool Load(Preferences &prefs, const char *key);
+  bool LoadLegacy(Preferences &prefs, const Watchlist &list); // false without old keys; their values are staged only when Load() found no blob
+  bool Commit(Preferences &prefs, const char *key); // the first one also removes the old keys
+  bool IsCommitDue(bool isForced) const; // changed, and forced or past the commit interval
+
+  void StageQuotes(const Watchlist &list, const float *prices, const float *yesterdayPrices);
+  void StageCurrencyDate(uint32_t date);
+  void StageWeather(float temp, int16_t humidity, const char *desc);
+
+  bool Quote(WatchType type, const char *symbol, float &price, float &yesterdayPrice) const;
+  uint32_t CurrencyDate() const;
+  bool Weather(float &temp, int16_t &humidity, char *desc, size_t size) const; // false until staged once
+
+  const MarketCacheStats &Stats() const;
+  static float WearYears(const MarketCacheStats &stats); // at the write rate since boot until the nvs partition is worn out
+
+private:
+  void MarkChanged();
+  void RemoveLegacy(Preferences &prefs);
+
+  uint8_t count = 0;
+  int16_t humidity = 0;
+  uint32_t currencyDate = 0;
+  float temp = 0;
+  char desc[MARKET_CACHE_DESC_SIZE] = {};
+  char symbols[WATCHLIST_MAX_SYMBOLS][WATCHLIST_SYMBOL_SIZE];
+  WatchType types[WATCHLIST_MAX_SYMBOLS];
+  float prices[WATCHLIST_MAX_SYMBOLS];
+  float yesterdayPrices[WATCHLIST_MAX_SYMBOLS];
+
+  bool isLoaded = false;
+  bool isLegacy = false; // old keys still in NVS
+
+  bool isDirty = false;
+  unsigned long commitMillis = 0;
+  MarketCacheStats stats = {};
+};
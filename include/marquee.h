@@ -0,0 +1,103 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "compositor.h"
+#include "glyph_cache.h"
+
+#define MARQUEE_MAX 4
+#define MARQUEE_MAX_STRIP_WIDTH 512   // px, longer text is cut
+#define MARQUEE_STRIP_STEP 64         // px, the strip width is rounded up to this so similar lines reuse it
+#define MARQUEE_GAP 32                // px between the end of the text and its repeat
+#define MARQUEE_SPEED_PX_PER_SEC 40   // one pixel per step
+#define MARQUEE_PAUSE_MS 1500         // the start of the text rests at the left edge this long
+#define MARQUEE_FRAME_MS 25           // at most 40 steps per second
+#define MARQUEE_FRAME_BUDGET_US 3000  // CPU per step for every marquee together
+
+// One sprite shared by every marquee, a row per scrolling text, as wide as
+// the widest of them. Nothing is allocated until a text needs to scroll and
+// the sprite is freed when the last one stops. A size change allocates the
+// new sprite before the old one is freed and copies the rows in use over.
+class MarqueeStrip
+{
+public:
+  MarqueeStrip(TFT_eSPI *display, int16_t rowHeight);
+
+  int8_t Acquire(int8_t row, int16_t width); // keeps row when >= 0, else takes a free one; -1 when out of memory
+  void Release(int8_t row);
+  TFT_eSprite &Sprite();
+  int16_t RowY(int8_t row);
+  int16_t RowHeight();
+  uint32_t Bytes();     // allocated now
+  uint32_t BytesPeak(); // most allocated at once since boot
+
+private:
+  bool Resize(int16_t width, uint8_t rows);
+
+  TFT_eSprite sprites[2]; // the one in use and the next size
+  uint8_t current = 0;
+  int16_t rowHeight;
+  uint8_t usedRows = 0; // bit per row
+  int16_t rowWidths[MARQUEE_MAX] = {};
+  uint32_t bytesPeak = 0;
+};
+
+// Text too long for its viewport, rendered once into a row of the shared
+// strip (text, gap) that a viewport scrolls over. A step only copies the
+// visible window to the canvas, wrapping at the end of the text. The offset
+// follows the clock, so a step that comes late jumps instead of slowing the
+// scroll.
+class Marquee
+{
+public:
+  Marquee(MarqueeStrip &strip, int16_t x, int16_t y, int16_t w, int16_t textY);
+
+  bool Start(GlyphCache &glyphs, const char *text, uint16_t length, uint16_t fg, uint16_t bg); // false when the text fits, nothing to scroll
+  void Stop();
+  bool IsRunning();
+  bool Step(Compositor &compositor, unsigned long nowMillis); // true when the window moved
+  uint32_t NextStepMs(unsigned long nowMillis);
+
+private:
+  int16_t Offset(unsigned long nowMillis);
+
+  MarqueeStrip &strip;
+  int8_t row = -1; // of the strip, held while running
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t textY;
+  int16_t stripWidth = 0; // columns of the row the current text uses
+  bool isRunning = false;
+  unsigned long startMillis = 0;
+  uint32_t periodMs = 0;
+  int16_t shownOffset = -1;
+};
+
+struct MarqueeStats
+{
+  uint32_t frames;
+  uint32_t steps;         // windows copied
+  uint32_t deferred;      // marquees left for the next frame, budget spent
+  uint32_t busyMicrosMax; // longest frame
+};
+
+// Steps every running marquee at most once per frame, starting where the
+// previous frame ran out of budget, so they share a fixed CPU time slice.
+class MarqueeGroup
+{
+public:
+  void Add(Marquee &marquee);
+  void Step(Compositor &compositor);
+  void StopAll();
+  uint32_t NextStepMs(); // UINT32_MAX when nothing scrolls
+
+  const MarqueeStats &Stats();
+
+private:
+  Marquee *marquees[MARQUEE_MAX];
+  uint8_t count = 0;
+  uint8_t first = 0;
+  unsigned long frameMillis = 0;
+  MarqueeStats stats = {};
+};
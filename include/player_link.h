@@ -0,0 +1,92 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "serial_rx.h"
+
+// Text mode (default): "<screen>$<field>$<value>\n"
+// A PLAYER_LINK_HANDSHAKE_BINARY byte at a line boundary switches to binary
+// mode and is echoed back so the host knows the firmware supports it.
+// Binary frame, little endian:
+//   [0xA5][length u16][screen u8][field u8][type u8][payload][crc16 u16]
+// length counts screen..payload, crc16 (CCITT, init 0xFFFF) covers length..payload.
+// A PLAYER_LINK_HANDSHAKE_TEXT byte at a frame boundary switches back.
+#define PLAYER_LINK_HANDSHAKE_BINARY 0x02
+#define PLAYER_LINK_HANDSHAKE_TEXT 0x03
+#define PLAYER_LINK_SYNC 0xA5
+#define PLAYER_LINK_HEADER_SIZE 3 // sync + length
+#define PLAYER_LINK_CRC_SIZE 2
+#define PLAYER_LINK_MAX_BODY (SERIAL_RX_MAX_LINE - PLAYER_LINK_HEADER_SIZE - PLAYER_LINK_CRC_SIZE)
+#define PLAYER_LINK_NO_FIELD 0xFF
+
+enum PlayerLinkType : uint8_t
+{
+  LinkText, // UTF-8 or decimal text
+  LinkU32,
+  LinkBytes
+};
+
+enum PlayerLinkMode : uint8_t
+{
+  LinkModeText,
+  LinkModeBinary
+};
+
+struct PlayerLinkFrame
+{
+  int8_t screen;
+  uint8_t field;
+  PlayerLinkType type;
+  SerialSlice payload;
+};
+
+struct PlayerLinkStats
+{
+  uint32_t textFrames;
+  uint32_t binaryFrames;
+  uint32_t crcErrors;
+  uint32_t badLengths;
+  uint32_t resyncBytes; // bytes skipped while looking for a sync byte
+};
+
+class PlayerLink
+{
+public:
+  void Begin(SerialRx &rx, Print &ack);
+  bool Next(PlayerLinkFrame &frame); // payload valid until the next call
+  PlayerLinkMode Mode();
+  const PlayerLinkStats &Stats();
+
+private:
+  bool NextText(PlayerLinkFrame &frame);
+  bool NextBinary(PlayerLinkFrame &frame);
+
+  SerialRx *rx = nullptr;
+  Print *ack = nullptr;
+  std::atomic<PlayerLinkMode> mode{LinkModeText}; // read by the log from any task
+  uint32_t pendingConsume = 0; // binary frame handed out, consumed on the next call
+  PlayerLinkStats stats = {};
+};
+
+// Diagnostic lines for the host. In text mode they go out as printed, in binary
+// mode each write becomes one LinkText frame on the given screen and field,
+// line end dropped, so log lines never break the host's frame parser. Any task
+// may print as long as a line goes out in one call, printf does.
+class PlayerLinkLog : public Print
+{
+public:
+  void Begin(Print &out, PlayerLink &link, int8_t screen, uint8_t field);
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+private:
+  Print *out = nullptr;
+  PlayerLink *link = nullptr;
+  int8_t screen = 0;
+  uint8_t field = 0;
+};
+
+uint16_t PlayerLinkCrc16(const uint8_t *data, uint16_t length, uint16_t crc = 0xFFFF);
+uint32_t PlayerLinkU32(const PlayerLinkFrame &frame);
+void PlayerLinkWrite(Print &out, int8_t screen, uint8_t field, PlayerLinkType type, const uint8_t *payload, uint16_t length);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define POSITION_CLOCK_SNAP_MS 1500   // larger host/local differences are seeks, applied at once
+#define POSITION_CLOCK_SLEW_DIVISOR 10 // smaller ones are absorbed at most 1 ms per 10 ms played
+
+struct PositionClockStats
+{
+  uint32_t syncs;
+  uint32_t snaps;
+  int32_t lastErrorMs; // host - local at the last sync, before correction
+  uint32_t maxAbsErrorMs;
+  uint32_t meanAbsErrorMs; // moving average over recent syncs
+  int32_t driftPpm;        // local clock rate error, moving average
+};
+
+// Playback position extrapolated from the monotonic esp_timer while playing.
+// Host positions are sync points: the difference to the local estimate is
+// slewed in over time so the position never jumps back for small errors.
+class PositionClock
+{
+public:
+  void Sync(uint32_t hostMs);
+  void SetPlaying(bool playing);
+  uint32_t PositionMs();
+  const PositionClockStats &Stats();
+
+private:
+  uint32_t Estimate(int64_t nowMicros);
+
+  bool isPlaying = false;
+  uint32_t baseMs = 0;       // position at baseMicros, correction not included
+  int64_t baseMicros = 0;
+  int32_t correctionMs = 0;  // still to be slewed in, counted from baseMicros
+  int64_t lastSyncMicros = 0;
+  bool hasPlayedSinceSync = false;
+  PositionClockStats stats = {};
+};
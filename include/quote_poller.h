@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+#include "watchlist.h"
+#include "time.h"
+
+#define QUOTE_POLL_MIN_MS 5000   // mis.twse.com.tw refreshes a quote about every 5 s
+#define QUOTE_POLL_MAX_MS 60000  // a symbol without trades is still asked once a minute
+#define QUOTE_POLL_GAP_MS 2000   // between two requests, the site blocks clients polling faster
+#define QUOTE_POLL_AHEAD_MS 3000 // symbols due this soon ride along with a request going out now
+
+enum TwsePhase
+{
+  TwseClosed,
+  TwseContinuous,     // 09:00 - 13:25, trades match as orders come in
+  TwseClosingAuction, // 13:25 - 13:30, orders collected, the close is printed at 13:30
+};
+
+struct QuotePollerStats
+{
+  uint32_t date;     // yyyymmdd of the session, 0 = none yet
+  uint32_t requests;
+  uint32_t symbolsPolled;
+  uint32_t trades;       // polls that found a trade newer than the one seen before
+  uint64_t ageMsTotal;   // trade time to fetch time, over those polls
+  uint32_t ageMsMax;
+};
+
+// Decides which TWSE symbols to ask for and when, by the tlong trade
+// timestamp of each quote: a symbol whose last trade moved on since the
+// previous poll is asked twice as often, one that stayed put half as often,
+// between QUOTE_POLL_MIN_MS and QUOTE_POLL_MAX_MS. Symbols due at about the
+// same time share one request. Polling starts with the session at 09:00, goes
+// on through the closing auction and ends with one pass over every symbol for
+// the closing print. HTTP task only.
+class QuotePoller
+{
+public:
+  void Begin(Print &out); // session summaries go here
+  void Reset();           // symbols moved, everything is due again
+
+  // up to maxCount indexes of the count stocks to fetch now, 0 = nothing due
+  uint8_t Due(const struct tm &now, unsigned long nowMillis, uint8_t count, uint8_t *indexes, uint8_t maxCount);
+  void Polled(uint8_t index, uint64_t tradeMs, uint64_t nowEpochMs, unsigned long nowMillis);
+
+  static TwsePhase Phase(const struct tm &now);
+
+  const QuotePollerStats &Stats();       // session running or last one
+  float AverageAgeSec();
+
+private:
+  void StartSession(const struct tm &now, unsigned long nowMillis);
+  void EndSession();
+  uint8_t DueClosing(uint8_t count, uint8_t *indexes, uint8_t maxCount);
+
+  Print *out = nullptr;
+  uint32_t intervalMs[WATCHLIST_MAX_SYMBOLS];
+  unsigned long dueMillis[WATCHLIST_MAX_SYMBOLS];
+  uint64_t tradeMs[WATCHLIST_MAX_SYMBOLS] = {};
+  bool isSessionOpen = false;
+  bool isClosingPoll = false;
+  uint8_t closingNext = 0; // next symbol of the closing pass
+  unsigned long requestMillis = 0;
+  QuotePollerStats stats = {};
+};
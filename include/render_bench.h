@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "compositor.h"
+
+#define RENDER_BENCH_MAX_CASES 8
+
+struct RenderBenchCase
+{
+  const char *name;
+  uint32_t budgetUs; // per frame: render plus push of the dirty area
+  uint32_t runs;
+  uint64_t cyclesTotal;
+  uint32_t cyclesMax;
+  uint64_t pixelsTotal;
+  uint32_t pixelsMax;
+};
+
+// Times render routines one at a time: a run draws into the canvas and
+// flushes what it marked dirty, and records CPU cycles and pixels pushed.
+// Cycles come from ESP.getCycleCount(), on the host that is host time.
+class RenderBench
+{
+public:
+  RenderBench(Compositor &compositor);
+
+  int8_t Add(const char *name, uint32_t budgetUs); // returns case id, -1 when full
+  void Run(int8_t id, const std::function<void()> &draw);
+  bool Report(); // prints one line per case, false if any run was over budget
+
+private:
+  Compositor &compositor;
+  RenderBenchCase cases[RENDER_BENCH_MAX_CASES];
+  uint8_t caseCount = 0;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#define RENDER_EVENT_TICK (1 << 0)   // wall clock second boundary
+#define RENDER_EVENT_SERIAL (1 << 1) // bytes arrived from the PC
+#define RENDER_EVENT_HTTP (1 << 2)   // HTTP task published new data
+#define RENDER_WAIT_FOREVER UINT32_MAX
+#define RENDER_TICK_MARGIN_US 2000   // fire just after the boundary so localtime already shows the new second
+#define RENDER_STATS_WINDOW_MS 10000
+
+struct RenderSchedulerStats
+{
+  uint32_t ticks;
+  uint32_t serialEvents;
+  uint32_t httpEvents;
+  uint32_t timeouts;
+  float wakeupsPerSec; // over the last stats window
+  float busyPercent;   // share of the window the render task was not waiting
+};
+
+// The render task sleeps on its task notification until the second tick,
+// serial data or fresh HTTP data wakes it (or its own deadline passes).
+// Build with -D RENDER_SCHEDULER_DISABLE to measure the old busy polling loop.
+class RenderScheduler
+{
+public:
+  void Begin(); // from the render task
+  void Notify(uint32_t events); // any task
+  uint32_t Wait(uint32_t timeoutMs); // returns event bits, 0 = timed out
+
+  const RenderSchedulerStats &Stats();
+
+private:
+  static void OnTick(void *arg);
+  void ArmTick();
+  void UpdateRate(int64_t now);
+
+  TaskHandle_t task = nullptr;
+  esp_timer_handle_t tickTimer = nullptr;
+  int64_t wakeMicros = 0;
+  int64_t busyMicros = 0;
+  int64_t windowStartMicros = 0;
+  uint32_t windowWakeups = 0;
+  RenderSchedulerStats stats = {};
+};
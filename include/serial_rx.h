@@ -0,0 +1,124 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <functional>
+
+#define SERIAL_RX_RING_SIZE 2048 // power of 2
+#define SERIAL_RX_MAX_LINE 512
+#define SERIAL_RX_CANCEL 0x18 // inserted by the producer into a line that lost bytes
+
+// Points into the receive ring (or its wrap scratch), valid until the next consumer call
+struct SerialSlice
+{
+  const char *data;
+  uint16_t length;
+};
+
+struct SerialRxStats
+{
+  uint32_t bytes;         // bytes copied into the ring
+  uint32_t frames;        // lines delivered
+  uint32_t overrunBytes;  // bytes dropped because the ring was full, or discarded with a damaged line
+  uint32_t uartErrors;    // UART buffer or FIFO overflows, the driver lost an unknown number of bytes
+  uint32_t droppedFrames; // lines dropped because they lost bytes or were too long
+};
+
+// UART bytes are copied into a single producer / single consumer ring from the
+// UART event task. The main loop frames lines in place and never blocks.
+// Byte level access (Peek/Slice/Consume) is there for binary framing. In
+// binary mode an overrun only drops the bytes that did not fit, no line is
+// discarded or marked: the frame they belonged to fails its CRC and the
+// parser resyncs on the next sync byte.
+class SerialRx
+{
+public:
+  void Begin(HardwareSerial &serial);
+  void OnData(std::function<void()> callback); // runs in the UART event task after bytes were queued
+  void SetBinary(bool isBinary);               // consumer switched framing, changes overrun handling
+
+  // consumer side only
+  bool NextLine(SerialSlice &line);
+  void Release();
+  bool IsLineInProgress();
+  uint32_t Available();
+  uint8_t Peek(uint32_t offset);
+  SerialSlice Slice(uint32_t offset, uint16_t length); // length <= SERIAL_RX_MAX_LINE
+  void Consume(uint32_t count);
+
+  const SerialRxStats &Stats();
+
+private:
+  void Produce();
+  void Push(uint8_t c);
+  bool WriteMarker();
+
+  HardwareSerial *serial = nullptr;
+  std::function<void()> onData;
+  uint8_t ring[SERIAL_RX_RING_SIZE];
+  std::atomic<uint32_t> head{0}; // written by producer only
+  std::atomic<uint32_t> tail{0}; // written by consumer only
+  std::atomic<bool> isBinary{false}; // written by consumer only
+  bool isDiscarding = false;     // producer lost bytes, drop until end of line
+  bool isMarkerPending = false;  // producer still has to terminate the damaged line
+
+  uint32_t scanPos = 0;          // consumer scan position, so a partial line is scanned once
+  uint32_t releasePos = 0;       // where Release() moves tail to
+  bool isHolding = false;        // a delivered line is not released yet
+  bool isLineCancelled = false;  // current line contains the producer marker
+  bool isSkippingLine = false;   // consumer dropped an overlong line, skip its tail
+  char scratch[SERIAL_RX_MAX_LINE];
+  SerialRxStats stats = {}; // 32 bit fields, each written by one side only
+};
+
+// **Slice helpers**
+inline int SliceIndexOf(const SerialSlice &slice, char c, int from = 0)
+{
+  for (int i = from; i < slice.length; i++)
+  {
+    if (slice.data[i] == c)
+      return i;
+  }
+  return -1;
+}
+
+inline int SliceLastIndexOf(const SerialSlice &slice, char c)
+{
+  for (int i = slice.length - 1; i >= 0; i--)
+  {
+    if (slice.data[i] == c)
+      return i;
+  }
+  return -1;
+}
+
+inline SerialSlice SliceSub(const SerialSlice &slice, int from, int to)
+{
+  from = constrain(from, 0, (int)slice.length);
+  to = constrain(to, from, (int)slice.length);
+  return {slice.data + from, (uint16_t)(to - from)};
+}
+
+inline float SliceToFloat(const SerialSlice &slice)
+{
+  char buf[24];
+  uint16_t length = min<uint16_t>(slice.length, sizeof(buf) - 1);
+  memcpy(buf, slice.data, length);
+  buf[length] = '\0';
+  return strtof(buf, nullptr);
+}
+
+inline long SliceToInt(const SerialSlice &slice)
+{
+  char buf[24];
+  uint16_t length = min<uint16_t>(slice.length, sizeof(buf) - 1);
+  memcpy(buf, slice.data, length);
+  buf[length] = '\0';
+  return strtol(buf, nullptr, 10);
+}
+
+inline void SliceAssign(String &dst, const SerialSlice &slice)
+{
+  dst = "";
+  dst.concat(slice.data, slice.length);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Seqlock around a plain struct: one task publishes whole copies, any other
+// task reads a consistent copy without locking (it retries if a publish was in
+// progress). T must be trivially copyable, e.g. char arrays instead of String.
+template <typename T>
+class Snapshot
+{
+public:
+  // writer side, one task only
+  void Publish(const T &value)
+  {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed); // odd = write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&data, &value, sizeof(T));
+    sequence.store(seq + 2, std::memory_order_release);
+  }
+
+  // 0 until the first Publish(), then increases by one per Publish()
+  uint32_t Version()
+  {
+    return sequence.load(std::memory_order_acquire) / 2;
+  }
+
+  // copies the latest value out, returns its version
+  uint32_t Read(T &value)
+  {
+    uint32_t before, after;
+    do
+    {
+      before = sequence.load(std::memory_order_acquire);
+      memcpy(&value, &data, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return before / 2;
+  }
+
+private:
+  std::atomic<uint32_t> sequence{0};
+  T data = {};
+};
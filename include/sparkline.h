@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "compositor.h"
+#include "intraday_history.h"
+
+#define SPARKLINE_RANGE_STEP 100 // ticks, the vertical range grows in steps of 0.1%
+#define SPARKLINE_UP_COLOR 0xF800
+#define SPARKLINE_DOWN_COLOR 0x07E0
+#define SPARKLINE_FLAT_COLOR 0xFFFF
+#define SPARKLINE_BASELINE_COLOR 0x4208 // previous close
+
+struct SparklineStats
+{
+  uint32_t fullDraws;
+  uint32_t shifts;         // incremental draws that scrolled the plot
+  uint32_t columnsDrawn;
+};
+
+// Newest ticks of one history entry as a line plot in a fixed canvas area,
+// one column per minute, previous close in the middle. While the same entry
+// stays on screen a new tick shifts the plot left and draws only the new
+// columns; a new entry, or a tick beyond the current range, redraws it all.
+class Sparkline
+{
+public:
+  Sparkline(TFT_eSprite &canvas, Compositor &compositor, int16_t x, int16_t y, int16_t w, int16_t h);
+
+  void Draw(const IntradayHistory &history, uint8_t index);
+  void Invalidate(); // the area was cleared by someone else, next Draw is a full one
+
+  const SparklineStats &Stats();
+
+private:
+  void DrawFull(const IntradayHistory &history, uint8_t index);
+  void DrawColumn(const IntradayHistory &history, uint8_t index, uint16_t age);
+  void ShiftLeft(int16_t columns);
+  int16_t TickY(int16_t tick);
+  int16_t RangeFor(const IntradayHistory &history, uint8_t index);
+
+  TFT_eSprite &canvas;
+  Compositor &compositor;
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+
+  bool isDrawn = false;
+  uint8_t drawnIndex = 0;
+  uint32_t drawnAppended = 0;
+  int16_t drawnNewest = 0;
+  int16_t range = SPARKLINE_RANGE_STEP; // ticks from the middle to the top or bottom row
+  SparklineStats stats = {};
+};
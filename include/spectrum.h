@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "compositor.h"
+#include "player_link.h"
+
+// Band levels come in binary player link frames of screen SPECTRUM_SCREEN,
+// field SPECTRUM_FIELD_BANDS, type LinkBytes, little endian:
+//   [seq u16][host ms u32][level u8] x bands, 1 to SPECTRUM_MAX_BANDS
+// Levels are 0 - 255, already on the scale the host wants shown. About once
+// a second the display answers a frame it drew with
+//   [seq u16][host ms u32][device us u32]
+// on the same screen and field: the host ms echoed back for the host to time
+// the round trip, and the device time from the frame coming off the link to
+// its flush.
+#define SPECTRUM_SCREEN 2
+#define SPECTRUM_FIELD_BANDS 0
+#define SPECTRUM_MAX_BANDS 32
+#define SPECTRUM_FRAME_MS 16       // falling bars and peaks animate at about 60 Hz
+#define SPECTRUM_RELEASE_PER_MS 96 // level / 256 a bar falls per ms, full scale in about 0.7 s
+#define SPECTRUM_PEAK_HOLD_MS 600
+#define SPECTRUM_PEAK_FALL_PER_MS 48 // half the bar speed, after the hold
+#define SPECTRUM_ECHO_MS 1000
+#define SPECTRUM_PEAK_COLOR 0xFFFF
+#define SPECTRUM_LOW_COLOR 0x07E0  // lower half of the bar
+#define SPECTRUM_MID_COLOR 0xFFE0  // next quarter
+#define SPECTRUM_HIGH_COLOR 0xF800 // top quarter
+
+struct SpectrumStats
+{
+  uint32_t frames;       // band frames taken
+  uint32_t dropped;      // host frames missing from the seq, lost on the link
+  uint32_t merged;       // frames folded into a newer one before it was drawn
+  uint32_t badFrames;    // wrong field, type or length
+  uint32_t drawnFrames;  // frames that reached a flush
+  uint32_t rowsDrawn;    // bar and peak rows, summed over bands
+  uint32_t latencyMicrosTotal; // frame off the link to its flush, over drawnFrames
+  uint32_t latencyMicrosMax;
+};
+
+// Spectrum analyzer bars in a fixed canvas area, one per band the host
+// sends. A bar jumps up to a new level at once and falls back at a fixed
+// rate, a peak mark stays on top for a while and then falls slower; levels,
+// peaks and times are integers in 1/256 of a level. Each step draws only the
+// rows of a bar that changed between its old and new height.
+class Spectrum
+{
+public:
+  Spectrum(TFT_eSprite &canvas, Compositor &compositor, int16_t x, int16_t y, int16_t w, int16_t h);
+
+  void Begin(Print &out); // echoes go here
+  bool Feed(const PlayerLinkFrame &frame); // false when the frame was not band levels
+  void Step(unsigned long nowMillis);      // release, peaks and drawing
+  void Flushed();                          // the compositor pushed what Step drew
+  void Invalidate();                       // the area was cleared by someone else
+  uint32_t NextStepMs(unsigned long nowMillis); // UINT32_MAX while nothing moves
+
+  const SpectrumStats &Stats();
+  uint32_t AverageLatencyMicros();
+
+private:
+  void Layout(uint8_t count);
+  void Release(unsigned long nowMillis);
+  void DrawBand(uint8_t band, int16_t barHeight, int16_t peakHeight);
+  void FillBar(int16_t bandX, int16_t top, int16_t bottom); // rows top..bottom - 1, colored by zone
+  void DrawPeakRow(int16_t bandX, int16_t height, int16_t barHeight);
+  int16_t Height(uint32_t level);
+
+  TFT_eSprite &canvas;
+  Compositor &compositor;
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+  Print *out = nullptr;
+  int8_t screen = SPECTRUM_SCREEN;
+  uint8_t field = SPECTRUM_FIELD_BANDS;
+
+  uint8_t bandCount = 0;
+  int16_t bandWidth = 0; // bar plus gap
+  int16_t barWidth = 0;
+  int16_t bandsX = 0;    // left of the first bar, the bars are centered
+  uint32_t levels[SPECTRUM_MAX_BANDS] = {}; // 1/256 of a level
+  uint32_t peaks[SPECTRUM_MAX_BANDS] = {};
+  unsigned long peakMillis[SPECTRUM_MAX_BANDS] = {}; // when the peak was last pushed up
+  int16_t barsDrawn[SPECTRUM_MAX_BANDS] = {};  // px, as on the canvas
+  int16_t peaksDrawn[SPECTRUM_MAX_BANDS] = {}; // px, 0 = no mark
+  unsigned long stepMillis = 0;
+
+  bool isFrameDrawn = true; // the newest frame went out with a flush
+  bool isFrameStepped = false;
+  uint16_t seq = 0;
+  uint32_t hostMillis = 0;
+  unsigned long frameMicros = 0; // when the newest frame came off the link
+  unsigned long echoMillis = 0;
+  SpectrumStats stats = {};
+};
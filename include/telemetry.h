@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Arduino.h>
+#include "player_link.h"
+#include "http_pool.h"
+#include "http_scheduler.h"
+
+// Commands come over the player link with this screen value:
+//   text   "9$0$"       dump every metric once as [TELEM] lines
+//          "9$1$<ms>"   stream binary samples every <ms>, 0 stops
+//   binary screen 9, same fields, period as text or u32
+// Samples are binary player link frames (screen 9, field
+// TELEMETRY_FIELD_SAMPLE, type LinkBytes) in either link mode, so the host
+// finds them between log lines by their sync byte and crc. Sample payload,
+// little endian:
+//   [version u8][uptime ms u32][free heap u32][largest block u32][min free heap u32]
+//   [pending HTTP jobs u8][task count u8][stack free u32 per task]
+//   [widget count u8][max us u32 per widget, since the previous sample]
+#define TELEMETRY_SCREEN 9
+#define TELEMETRY_FIELD_DUMP 0
+#define TELEMETRY_FIELD_STREAM 1
+#define TELEMETRY_FIELD_SAMPLE 0x80
+#define TELEMETRY_FIELD_LOG 0x81 // log lines in binary mode, LinkText
+#define TELEMETRY_SAMPLE_VERSION 1
+#define TELEMETRY_MIN_PERIOD_MS 100
+#define TELEMETRY_MAX_TASKS 4
+#define TELEMETRY_MAX_HTTP 4
+#define TELEMETRY_MAX_WIDGETS 16
+
+struct TelemetryWidgetStats
+{
+  uint32_t calls;
+  uint64_t microsTotal;
+  uint32_t microsMax;
+  uint32_t microsMaxSample; // since the last streamed sample
+};
+
+// Live metrics on request over serial: heap and fragmentation, task stack
+// high water marks, HTTP scheduler counters, latency histograms per request type
+// and render time per widget. Everything runs on the loop task.
+class Telemetry
+{
+public:
+  void Begin(Print &out, Print &log, const char *const *widgetNames, uint8_t widgetCount); // samples to out, dumps to log
+  void WatchTask(TaskHandle_t task);
+  void WatchScheduler(HttpScheduler &scheduler);
+  void WatchHttp(const HttpHostStats *stats, const char *const *names, uint8_t count);
+
+  void Command(const PlayerLinkFrame &frame);
+  void WidgetTime(uint8_t widget, uint32_t micros);
+  void Poll(); // sends a sample when one is due
+  uint32_t NextSampleMs(); // UINT32_MAX when not streaming
+  void Dump();
+
+private:
+  void SendSample();
+
+  Print *out = nullptr;
+  Print *logOut = nullptr;
+  const char *const *widgetNames = nullptr;
+  uint8_t widgetCount = 0;
+  TelemetryWidgetStats widgets[TELEMETRY_MAX_WIDGETS] = {};
+  TaskHandle_t tasks[TELEMETRY_MAX_TASKS];
+  uint8_t taskCount = 0;
+  HttpScheduler *scheduler = nullptr;
+  const HttpHostStats *httpStats = nullptr;
+  const char *const *httpNames = nullptr;
+  uint8_t httpCount = 0;
+  uint32_t periodMs = 0; // 0 = not streaming
+  unsigned long sampleMillis = 0;
+};
+
+// times the enclosing scope into one widget of the telemetry
+class TelemetrySpan
+{
+public:
+  TelemetrySpan(Telemetry &telemetry, uint8_t widget)
+      : telemetry(telemetry), widget(widget), startMicros(micros())
+  {
+  }
+  ~TelemetrySpan()
+  {
+    telemetry.WidgetTime(widget, micros() - startMicros);
+  }
+
+private:
+  Telemetry &telemetry;
+  uint8_t widget;
+  unsigned long startMicros;
+};
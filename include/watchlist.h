@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#define WATCHLIST_MAX_SYMBOLS 48
+#define WATCHLIST_SYMBOL_SIZE 8 // fixed width, NUL padded: TWSE codes and ISO currency codes
+#define WATCHLIST_POOL_SIZE 1024
+#define WATCHLIST_BLOB_VERSION 1
+#define WATCHLIST_BLOB_HEADER 6
+#define WATCHLIST_BLOB_MAX (WATCHLIST_BLOB_HEADER + WATCHLIST_MAX_SYMBOLS * (1 + WATCHLIST_SYMBOL_SIZE + 2) + WATCHLIST_POOL_SIZE)
+
+// Commands come over the player link with this screen value:
+//   "8$0$"               print the list as [WATCH] lines
+//   "8$1$sn_2317,鴻海"   add, prefix si_ index / se_ ETF / sn_ stock / cu_ currency
+//   "8$2$2317"           remove by symbol
+//   "8$3$"               back to the built-in list
+#define WATCHLIST_SCREEN 8
+#define WATCHLIST_FIELD_LIST 0
+#define WATCHLIST_FIELD_ADD 1
+#define WATCHLIST_FIELD_REMOVE 2
+#define WATCHLIST_FIELD_RESET 3
+
+enum WatchType : uint8_t
+{
+  WatchIndex,
+  WatchEtf,
+  WatchStock,
+  WatchCurrency
+};
+
+// Finance symbols as a struct of arrays: type, fixed width symbol and name
+// offset per entry, names NUL terminated in one pool. TWSE entries are kept
+// before currencies, so [0, StockCount()) is what getStockInfo is asked for.
+// Stored in NVS as one blob holding only the used part of every array.
+class Watchlist
+{
+public:
+  void Reset();
+  bool Add(const char *entry, uint16_t length); // "<prefix>_<symbol>,<name>"
+  bool Remove(const char *symbol, uint16_t length);
+  int16_t Find(WatchType type, const char *symbol) const; // -1 if missing
+
+  uint8_t Count() const;
+  uint8_t StockCount() const;
+  WatchType Type(uint8_t index) const;
+  const char *Symbol(uint8_t index) const;
+  const char *Name(uint8_t index) const;
+  const char *TypeLabel(uint8_t index) const; // "INDEX ", "ETF " or ""
+  uint16_t PoolUsed() const;
+
+  bool Load(Preferences &prefs, const char *key);
+  bool Save(Preferences &prefs, const char *key) const;
+
+private:
+  bool Insert(WatchType type, const char *symbol, uint8_t symbolLength, const char *name, uint16_t nameLength);
+
+  uint8_t count = 0;
+  uint8_t stockCount = 0;
+  uint16_t poolUsed = 0;
+  WatchType types[WATCHLIST_MAX_SYMBOLS];
+  char symbols[WATCHLIST_MAX_SYMBOLS][WATCHLIST_SYMBOL_SIZE];
+  uint16_t nameOffsets[WATCHLIST_MAX_SYMBOLS];
+  char pool[WATCHLIST_POOL_SIZE];
+};
@@ -0,0 +1,232 @@
+#pragma once
+
+// Host stand-in for the arduino-esp32 core, only what ML-Display uses.
+// Time is virtual (see native.h), so runs are deterministic and fast.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include "WString.h"
+
+using std::abs;
+using std::max;
+using std::min;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define ARDUINO_ISR_ATTR
+#define PGM_P const char *
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+template <typename T, typename L, typename H>
+inline T constrain(T value, L low, H high)
+{
+  return value < (T)low ? (T)low : value > (T)high ? (T)high : value;
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+long random(long max);
+long random(long min, long max);
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char *dst, const char *src, size_t size); // newlib has it, older glibc does not
+#endif
+
+#define log_e(format, ...) printf("[E] " format "\n", ##__VA_ARGS__)
+#define log_w(format, ...) printf("[W] " format "\n", ##__VA_ARGS__)
+#define log_i(format, ...)
+#define log_d(format, ...)
+#define log_v(format, ...)
+
+// **Print / Stream**
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    size_t count = 0;
+    while (size--)
+      count += write(*buffer++);
+    return count;
+  }
+  size_t write(const char *str) { return str != nullptr ? write((const uint8_t *)str, strlen(str)) : 0; }
+  size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+  virtual void flush() {}
+
+  size_t print(const String &str) { return write(str.c_str(), str.length()); }
+  size_t print(const char *str) { return write(str); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC) { return print(String(value, base)); }
+  size_t print(int value, int base = DEC) { return print(String(value, base)); }
+  size_t print(unsigned int value, int base = DEC) { return print(String(value, base)); }
+  size_t print(long value, int base = DEC) { return print(String(value, base)); }
+  size_t print(unsigned long value, int base = DEC) { return print(String(value, base)); }
+  size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T &value)
+  {
+    size_t count = print(value);
+    return count + println();
+  }
+  template <typename T>
+  size_t println(const T &value, int format)
+  {
+    size_t count = print(value, format);
+    return count + println();
+  }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// host streams are in memory, so reads never wait for a timeout
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  virtual size_t readBytes(char *buffer, size_t length)
+  {
+    size_t count = 0;
+    int c;
+    while (count < length && (c = read()) >= 0)
+      buffer[count++] = c;
+    return count;
+  }
+  size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+  size_t readBytesUntil(char terminator, char *buffer, size_t length)
+  {
+    size_t count = 0;
+    int c;
+    while (count < length && (c = read()) >= 0 && c != terminator)
+      buffer[count++] = c;
+    return count;
+  }
+  String readStringUntil(char terminator)
+  {
+    String str;
+    int c;
+    while ((c = read()) >= 0 && c != terminator)
+      str.concat((char)c);
+    return str;
+  }
+  bool find(const char *target)
+  {
+    size_t matched = 0, length = strlen(target);
+    int c;
+    while (matched < length && (c = read()) >= 0)
+      matched = c == target[matched] ? matched + 1 : (c == target[0] ? 1 : 0);
+    return matched == length;
+  }
+  bool find(char *target) { return find((const char *)target); }
+  void setTimeout(unsigned long ms) { timeout = ms; }
+
+protected:
+  unsigned long timeout = 1000;
+};
+
+// **Serial**
+typedef enum
+{
+  UART_NO_ERROR,
+  UART_BREAK_ERROR,
+  UART_BUFFER_FULL_ERROR,
+  UART_FIFO_OVF_ERROR,
+  UART_FRAME_ERROR,
+  UART_PARITY_ERROR
+} hardwareSerial_error_t;
+
+// TX goes to stdout, RX is fed by the host through Inject()
+class HardwareSerial : public Stream
+{
+public:
+  void begin(unsigned long baud, uint32_t config = 0, int8_t rxPin = -1, int8_t txPin = -1, bool invert = false,
+             unsigned long timeoutMs = 20000UL, uint8_t rxfifoFullThrhd = 112) { this->baud = baud; }
+  void end() {}
+  uint32_t baudRate() { return baud; }
+  size_t setRxBufferSize(size_t size)
+  {
+    rxBufferSize = size;
+    return size;
+  }
+  bool setRxTimeout(uint8_t symbols) { return true; }
+  bool setRxFIFOFull(uint8_t bytes) { return true; }
+  void onReceive(std::function<void(void)> callback, bool onlyOnTimeout = false) { onReceiveCallback = callback; }
+  void onReceiveError(std::function<void(hardwareSerial_error_t)> callback) { onErrorCallback = callback; }
+
+  int available() override { return rx.size() - rxPos; }
+  int read() override { return rxPos < rx.size() ? (uint8_t)rx[rxPos++] : -1; }
+  int peek() override { return rxPos < rx.size() ? (uint8_t)rx[rxPos] : -1; }
+  size_t read(uint8_t *buffer, size_t size)
+  {
+    size = min(size, rx.size() - rxPos);
+    memcpy(buffer, rx.data() + rxPos, size);
+    rxPos += size;
+    return size;
+  }
+  using Print::write;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+
+  size_t Inject(const uint8_t *data, size_t size); // host side: bytes arrive, the receive callback runs
+
+private:
+  std::string rx;
+  size_t rxPos = 0;
+  size_t rxBufferSize = 256;
+  uint32_t baud = 0;
+  std::function<void(void)> onReceiveCallback;
+  std::function<void(hardwareSerial_error_t)> onErrorCallback;
+};
+extern HardwareSerial Serial;
+
+// **ESP**
+class EspClass
+{
+public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getHeapSize();
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 240; }
+  void restart();
+};
+extern EspClass ESP;
+
+// **Time**
+bool getLocalTime(struct tm *info, uint32_t ms = 5000);
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char *server1, const char *server2 = nullptr,
+                const char *server3 = nullptr);
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+void setup();
+void loop();
@@ -0,0 +1,22 @@
+#pragma once
+
+// The real font lives in the TFT_eSPI library folder of the Arduino IDE and is
+// found through the include path of the native env. Without it an empty VLW
+// font is used: text still takes space (missing glyph boxes) but has no shapes.
+// NATIVE_EMPTY_FONT picks the empty one anyway, for frames that must not depend
+// on the local font copy.
+#if __has_include(<Cubic12.h>) && !defined(NATIVE_EMPTY_FONT)
+#include <Cubic12.h>
+#else
+#ifndef NATIVE_EMPTY_FONT
+#warning "Cubic12.h not found, using an empty font for the native build"
+#endif
+const uint8_t Cubic12[] = {
+    0x00, 0x00, 0x00, 0x00, // gCount
+    0x00, 0x00, 0x00, 0x0B, // version
+    0x00, 0x00, 0x00, 0x0C, // yAdvance
+    0x00, 0x00, 0x00, 0x00, // unused
+    0x00, 0x00, 0x00, 0x0B, // ascent
+    0x00, 0x00, 0x00, 0x03, // descent
+};
+#endif
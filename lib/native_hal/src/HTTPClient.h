@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+
+// answers from the responses registered with NativeHttpServe(), bodies are
+// sent with a content length and never chunked
+class HTTPClient
+{
+public:
+  bool begin(WiFiClient &client, const String &url);
+  bool begin(const String &url);
+  void end();
+  int GET();
+  int getSize() { return size; }
+  String getString();
+  WiFiClient *getStreamPtr() { return client; }
+  WiFiClient &getStream() { return *client; }
+  void setReuse(bool reuse) { isReuse = reuse; }
+  void useHTTP10(bool useHTTP10) {}
+  void setTimeout(uint16_t timeout) {}
+  void collectHeaders(const char *headerKeys[], const size_t headerKeysCount) {}
+  String header(const char *name) { return String(); }
+  static String errorToString(int error);
+
+private:
+  WiFiClient ownClient;
+  WiFiClient *client = nullptr;
+  String url;
+  int size = -1;
+  bool isReuse = true;
+  bool isOwnClient = false; // begin(url) picks the transport from the scheme, like the device
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+
+// NVS stand-in: namespaces live in memory for the lifetime of the process
+class Preferences
+{
+public:
+  bool begin(const char *name, bool readOnly = false, const char *partitionLabel = nullptr);
+  void end();
+  bool clear();
+  bool remove(const char *key);
+  bool isKey(const char *key);
+
+  size_t putFloat(const char *key, float value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putInt(const char *key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putUInt(const char *key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putUChar(const char *key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putString(const char *key, const String &value) { return putBytes(key, value.c_str(), value.length() + 1) - 1; }
+  size_t putBytes(const char *key, const void *value, size_t length);
+
+  float getFloat(const char *key, float defaultValue = NAN) { return Get(key, defaultValue); }
+  int32_t getInt(const char *key, int32_t defaultValue = 0) { return Get(key, defaultValue); }
+  uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return Get(key, defaultValue); }
+  uint8_t getUChar(const char *key, uint8_t defaultValue = 0) { return Get(key, defaultValue); }
+  String getString(const char *key, const String &defaultValue = String());
+  size_t getBytesLength(const char *key);
+  size_t getBytes(const char *key, void *buffer, size_t maxLength);
+
+private:
+  template <typename T>
+  T Get(const char *key, T defaultValue)
+  {
+    T value;
+    return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : defaultValue;
+  }
+
+  std::string name;
+  bool isOpen = false;
+  bool isReadOnly = false;
+};
@@ -0,0 +1,3 @@
+#pragma once
+
+// the panel is a RAM buffer on the host, nothing talks SPI
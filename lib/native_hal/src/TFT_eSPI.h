@@ -0,0 +1,192 @@
+#pragma once
+
+// Host stand-in for TFT_eSPI: the panel and every sprite are RAM buffers of
+// 16 bit pixels in SPI byte order (big-endian RGB565), like TFT_eSprite memory.
+// Smooth (VLW) fonts are rendered from the real font data. Built-in bitmap
+// fonts only keep their metrics: glyphs are drawn as outlined cells, font 7
+// as seven segment digits, so layouts can be checked but not typography.
+
+#include <Arduino.h>
+#include <vector>
+
+#ifndef TFT_WIDTH
+#define TFT_WIDTH 128
+#endif
+#ifndef TFT_HEIGHT
+#define TFT_HEIGHT 160
+#endif
+
+#define TFT_BLACK 0x0000
+#define TFT_NAVY 0x000F
+#define TFT_DARKGREEN 0x03E0
+#define TFT_DARKCYAN 0x03EF
+#define TFT_MAROON 0x7800
+#define TFT_PURPLE 0x780F
+#define TFT_OLIVE 0x7BE0
+#define TFT_LIGHTGREY 0xD69A
+#define TFT_DARKGREY 0x7BEF
+#define TFT_BLUE 0x001F
+#define TFT_GREEN 0x07E0
+#define TFT_CYAN 0x07FF
+#define TFT_RED 0xF800
+#define TFT_MAGENTA 0xF81F
+#define TFT_YELLOW 0xFFE0
+#define TFT_WHITE 0xFFFF
+#define TFT_ORANGE 0xFDA0
+#define TFT_GREENYELLOW 0xB7E0
+#define TFT_PINK 0xFE19
+#define TFT_BROWN 0x9A60
+#define TFT_GOLD 0xFEA0
+#define TFT_SILVER 0xC618
+#define TFT_SKYBLUE 0x867D
+#define TFT_VIOLET 0x915C
+#define TFT_TRANSPARENT 0x0120
+
+#define TL_DATUM 0
+
+class TFT_eSprite;
+
+class TFT_eSPI : public Print
+{
+public:
+  TFT_eSPI(int16_t width = TFT_WIDTH, int16_t height = TFT_HEIGHT);
+  virtual ~TFT_eSPI() {}
+
+  void init(uint8_t tc = 0);
+  void begin(uint8_t tc = 0) { init(tc); }
+  void setRotation(uint8_t rotation);
+  uint8_t getRotation() { return rotation; }
+  int16_t width() { return _width; }
+  int16_t height() { return _height; }
+  void startWrite() {}
+  void endWrite() {}
+  void setSwapBytes(bool swap) { swapBytes = swap; }
+  bool getSwapBytes() { return swapBytes; }
+  static uint16_t color565(uint8_t r, uint8_t g, uint8_t b) { return (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3; }
+
+  // **Graphics**
+  void drawPixel(int32_t x, int32_t y, uint32_t color);
+  uint16_t readPixel(int32_t x, int32_t y);
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+  void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+  void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void fillScreen(uint32_t color);
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data) { pushImage(x, y, w, h, (const uint16_t *)data); }
+  void setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum = true); // drawing clipped to it, offset by its origin
+  void resetViewport();
+
+  // **DMA**, a transfer is done by the time it is queued
+  bool initDMA(bool ctrlCs = false) { return true; }
+  void deInitDMA() {}
+  bool dmaBusy() { return false; }
+  void dmaWait() {}
+  void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data, uint16_t *buffer = nullptr) { pushImage(x, y, w, h, (const uint16_t *)data); }
+
+  // **Text**
+  void setTextColor(uint16_t color);
+  void setTextColor(uint16_t fg, uint16_t bg, bool bgFill = false);
+  void setCursor(int16_t x, int16_t y);
+  void setTextFont(uint8_t font) { textFont = font; }
+  void setTextSize(uint8_t size) {}
+  void setTextDatum(uint8_t datum) {}
+  void setTextWrap(bool wrapX, bool wrapY = false) { textWrapX = wrapX; }
+  int16_t drawString(const String &str, int32_t x, int32_t y, uint8_t font) { return drawString(str.c_str(), x, y, font); }
+  int16_t drawString(const String &str, int32_t x, int32_t y) { return drawString(str.c_str(), x, y, textFont); }
+  int16_t drawString(const char *str, int32_t x, int32_t y) { return drawString(str, x, y, textFont); }
+  int16_t drawString(const char *str, int32_t x, int32_t y, uint8_t font);
+  int16_t drawChar(uint16_t c, int32_t x, int32_t y, uint8_t font);
+  int16_t drawNumber(long number, int32_t x, int32_t y, uint8_t font) { return drawString(String(number), x, y, font); }
+  int16_t drawNumber(long number, int32_t x, int32_t y) { return drawNumber(number, x, y, textFont); }
+  int16_t textWidth(const String &str, uint8_t font) { return textWidth(str.c_str(), font); }
+  int16_t textWidth(const String &str) { return textWidth(str.c_str(), textFont); }
+  int16_t textWidth(const char *str) { return textWidth(str, textFont); }
+  int16_t textWidth(const char *str, uint8_t font);
+  int16_t fontHeight(int16_t font);
+  int16_t fontHeight() { return fontHeight(textFont); }
+  using Print::write;
+  size_t write(uint8_t c) override;
+
+  // **Smooth fonts**
+  typedef struct
+  {
+    const uint8_t *gArray;
+    uint16_t gCount;
+    uint16_t yAdvance;
+    uint16_t spaceWidth;
+    int16_t ascent;
+    int16_t descent;
+    uint16_t maxAscent;
+    uint16_t maxDescent;
+  } fontMetrics;
+
+  void loadFont(const uint8_t array[]);
+  void unloadFont();
+  bool getUnicodeIndex(uint16_t unicode, uint16_t *index);
+  uint16_t alphaBlend(uint8_t alpha, uint16_t fgc, uint16_t bgc);
+  uint16_t decodeUTF8(uint8_t *buf, uint16_t *index, uint16_t remaining);
+
+  fontMetrics gFont = {nullptr, 0, 0, 0, 0, 0, 0, 0};
+  uint16_t *gUnicode = nullptr;
+  uint8_t *gHeight = nullptr;
+  uint8_t *gWidth = nullptr;
+  uint8_t *gxAdvance = nullptr;
+  int16_t *gdY = nullptr;
+  int8_t *gdX = nullptr;
+  uint32_t *gBitmap = nullptr;
+  bool fontLoaded = false;
+
+protected:
+  TFT_eSPI(int16_t width, int16_t height, bool isPanel);
+
+  void Resize(int16_t width, int16_t height);
+  void WritePixel(int32_t x, int32_t y, uint16_t color); // clipped, native colour
+  int16_t DrawBuiltinChar(uint16_t c, int32_t x, int32_t y, uint8_t font);
+  int16_t DrawSmoothChar(uint16_t code, int32_t x, int32_t y);
+  int16_t BuiltinCharWidth(uint16_t c, uint8_t font);
+
+  std::vector<uint16_t> pixels; // SPI byte order
+  int16_t _width;
+  int16_t _height;
+  uint8_t rotation = 0;
+  bool isPanel;
+  bool swapBytes = false;
+  uint16_t textColor = TFT_WHITE;
+  uint16_t textBgColor = TFT_WHITE;
+  uint8_t textFont = 1;
+  int32_t cursorX = 0;
+  int32_t cursorY = 0;
+  bool textWrapX = true;
+  int32_t vpX = 0; // viewport, clip and origin of every pixel written
+  int32_t vpY = 0;
+  int32_t vpW = INT16_MAX;
+  int32_t vpH = INT16_MAX;
+  bool vpDatum = true;
+
+  friend class TFT_eSprite;
+  friend const uint16_t *NativePanelPixels();
+  friend int16_t NativePanelWidth();
+  friend int16_t NativePanelHeight();
+};
+
+class TFT_eSprite : public TFT_eSPI
+{
+public:
+  explicit TFT_eSprite(TFT_eSPI *tft);
+
+  void *createSprite(int16_t width, int16_t height, uint8_t frames = 1);
+  void deleteSprite();
+  bool created() { return isCreated; }
+  void *setColorDepth(int8_t bits); // only 16 bit sprites exist here
+  int8_t getColorDepth() { return 16; }
+  void *getPointer() { return isCreated ? pixels.data() : nullptr; }
+  void fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+  void pushSprite(int32_t x, int32_t y);
+  bool pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh);
+  bool pushToSprite(TFT_eSprite *dst, int32_t x, int32_t y);
+
+private:
+  TFT_eSPI *parent;
+  bool isCreated = false;
+};
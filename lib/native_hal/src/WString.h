@@ -0,0 +1,212 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class StringSumHelper;
+
+// Arduino String on top of std::string, same observable behavior for what the firmware uses
+class String
+{
+public:
+  String() {}
+  String(const char *str) : s(str != nullptr ? str : "") {}
+  String(const char *str, unsigned int length) : s(str, length) {}
+  String(const std::string &str) : s(str) {}
+  String(char c) : s(1, c) {}
+  String(unsigned char value, unsigned char base = DEC) : s(FromUnsigned(value, base)) {}
+  String(int value, unsigned char base = DEC) : s(FromSigned(value, base)) {}
+  String(unsigned int value, unsigned char base = DEC) : s(FromUnsigned(value, base)) {}
+  String(long value, unsigned char base = DEC) : s(FromSigned(value, base)) {}
+  String(unsigned long value, unsigned char base = DEC) : s(FromUnsigned(value, base)) {}
+  String(long long value, unsigned char base = DEC) : s(FromSigned(value, base)) {}
+  String(unsigned long long value, unsigned char base = DEC) : s(FromUnsigned(value, base)) {}
+  String(float value, unsigned int decimals = 2) : s(FromDouble(value, decimals)) {}
+  String(double value, unsigned int decimals = 2) : s(FromDouble(value, decimals)) {}
+
+  String &operator=(const char *str)
+  {
+    s = str != nullptr ? str : "";
+    return *this;
+  }
+
+  unsigned int length() const { return s.size(); }
+  const char *c_str() const { return s.c_str(); }
+  bool isEmpty() const { return s.empty(); }
+  bool reserve(unsigned int size)
+  {
+    s.reserve(size);
+    return true;
+  }
+
+  bool concat(const String &str)
+  {
+    s += str.s;
+    return true;
+  }
+  bool concat(const char *str)
+  {
+    if (str != nullptr)
+      s += str;
+    return true;
+  }
+  bool concat(const char *str, unsigned int length)
+  {
+    s.append(str, length);
+    return true;
+  }
+  bool concat(char c)
+  {
+    s += c;
+    return true;
+  }
+  template <typename T>
+  bool concat(T value)
+  {
+    return concat(String(value));
+  }
+
+  template <typename T>
+  String &operator+=(const T &value)
+  {
+    concat(value);
+    return *this;
+  }
+
+  char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+  void setCharAt(unsigned int index, char c)
+  {
+    if (index < s.size())
+      s[index] = c;
+  }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index) { return s[index]; }
+
+  int compareTo(const String &str) const { return s.compare(str.s); }
+  bool equals(const String &str) const { return s == str.s; }
+  bool equals(const char *str) const { return s == (str != nullptr ? str : ""); }
+  bool equalsIgnoreCase(const String &str) const
+  {
+    return s.size() == str.s.size() && strncasecmp(s.c_str(), str.s.c_str(), s.size()) == 0;
+  }
+  bool operator==(const String &str) const { return equals(str); }
+  bool operator==(const char *str) const { return equals(str); }
+  bool operator!=(const String &str) const { return !equals(str); }
+  bool operator!=(const char *str) const { return !equals(str); }
+  bool operator<(const String &str) const { return s < str.s; }
+
+  bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+  bool endsWith(const String &suffix) const
+  {
+    return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+  }
+
+  int indexOf(char c, unsigned int from = 0) const { return Found(s.find(c, from)); }
+  int indexOf(const String &str, unsigned int from = 0) const { return Found(s.find(str.s, from)); }
+  int lastIndexOf(char c) const { return Found(s.rfind(c)); }
+  int lastIndexOf(char c, unsigned int from) const { return Found(s.rfind(c, from)); }
+  int lastIndexOf(const String &str) const { return Found(s.rfind(str.s)); }
+
+  String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const
+  {
+    if (from > to)
+      std::swap(from, to);
+    if (from >= s.size())
+      return String();
+    return String(s.substr(from, to - from));
+  }
+
+  void replace(const String &find, const String &replacement)
+  {
+    if (find.s.empty())
+      return;
+    for (size_t pos = s.find(find.s); pos != std::string::npos; pos = s.find(find.s, pos + replacement.s.size()))
+      s.replace(pos, find.s.size(), replacement.s);
+  }
+  void remove(unsigned int index) { remove(index, s.size()); }
+  void remove(unsigned int index, unsigned int count)
+  {
+    if (index < s.size())
+      s.erase(index, count);
+  }
+  void toUpperCase()
+  {
+    for (char &c : s)
+      c = toupper((unsigned char)c);
+  }
+  void toLowerCase()
+  {
+    for (char &c : s)
+      c = tolower((unsigned char)c);
+  }
+  void trim()
+  {
+    size_t begin = s.find_first_not_of(" \t\r\n\f\v");
+    size_t end = s.find_last_not_of(" \t\r\n\f\v");
+    s = begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+  }
+
+  long toInt() const { return strtol(s.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s.c_str(), nullptr); }
+  double toDouble() const { return strtod(s.c_str(), nullptr); }
+
+  friend StringSumHelper operator+(const String &a, const String &b);
+
+private:
+  static int Found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+  static std::string FromUnsigned(unsigned long long value, unsigned char base)
+  {
+    if (value == 0)
+      return "0";
+    std::string out;
+    for (; value; value /= base)
+      out.insert(out.begin(), "0123456789abcdef"[value % base]);
+    return out;
+  }
+  static std::string FromSigned(long long value, unsigned char base)
+  {
+    if (base == DEC && value < 0)
+      return "-" + FromUnsigned(-(unsigned long long)value, base);
+    return FromUnsigned((unsigned long long)value, base);
+  }
+  static std::string FromDouble(double value, unsigned int decimals)
+  {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    return buf;
+  }
+
+  std::string s;
+};
+
+// result type of String concatenation, kept as a separate type like the Arduino core (ArduinoJson relies on it)
+class StringSumHelper : public String
+{
+public:
+  StringSumHelper(const String &str) : String(str) {}
+};
+
+inline StringSumHelper operator+(const String &a, const String &b)
+{
+  String sum = a;
+  sum.concat(b);
+  return StringSumHelper(sum);
+}
+inline StringSumHelper operator+(const String &a, const char *b) { return a + String(b); }
+inline StringSumHelper operator+(const char *a, const String &b) { return String(a) + b; }
+inline StringSumHelper operator+(const String &a, char b) { return a + String(b); }
+inline StringSumHelper operator+(const String &a, int b) { return a + String(b); }
+inline StringSumHelper operator+(const String &a, unsigned int b) { return a + String(b); }
+inline StringSumHelper operator+(const String &a, long b) { return a + String(b); }
+inline StringSumHelper operator+(const String &a, unsigned long b) { return a + String(b); }
+inline StringSumHelper operator+(const String &a, float b) { return a + String(b); }
+inline StringSumHelper operator+(const String &a, double b) { return a + String(b); }
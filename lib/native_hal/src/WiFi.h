@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+
+typedef enum
+{
+  WL_IDLE_STATUS = 0,
+  WL_CONNECTED = 3,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+// socket of the fake network, holds the body of the last response
+class WiFiClient : public Stream
+{
+public:
+  virtual ~WiFiClient() {}
+
+  int available() override { return data.size() - pos; }
+  int read() override { return pos < data.size() ? (uint8_t)data[pos++] : -1; }
+  int peek() override { return pos < data.size() ? (uint8_t)data[pos] : -1; }
+  size_t write(uint8_t c) override { return 1; }
+  using Print::write;
+  uint8_t connected() { return isConnected; }
+  virtual bool IsSecure() { return false; } // native only, checked against the URL scheme
+  void stop()
+  {
+    isConnected = false;
+    data.clear();
+    pos = 0;
+  }
+
+  void Load(const std::string &body) // the next response arrives on this socket
+  {
+    isConnected = true;
+    data = body;
+    pos = 0;
+  }
+
+private:
+  std::string data;
+  size_t pos = 0;
+  bool isConnected = false;
+};
+
+class WiFiClass
+{
+public:
+  wl_status_t begin(const char *ssid, const char *password = nullptr) { return WL_CONNECTED; }
+  wl_status_t status() { return WL_CONNECTED; }
+  bool disconnect(bool wifiOff = false) { return true; }
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <WiFi.h>
+
+// no TLS on the fake network, certificates are accepted and ignored
+class WiFiClientSecure : public WiFiClient
+{
+public:
+  void setInsecure() {}
+  void setCACert(const char *rootCA) {}
+  void setHandshakeTimeout(unsigned long seconds) {}
+  bool IsSecure() override { return true; }
+};
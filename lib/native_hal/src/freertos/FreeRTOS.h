@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Tasks are host threads, ticks are 1 ms of virtual time
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+typedef struct NativeTask *TaskHandle_t;
+typedef struct NativeQueue *QueueHandle_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define configTICK_RATE_HZ 1000
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+// critical sections spin like the ESP32 dual core port, tasks really run in parallel here
+typedef struct
+{
+  std::atomic_flag isLocked;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {ATOMIC_FLAG_INIT}
+#define portENTER_CRITICAL(mux) while ((mux)->isLocked.test_and_set(std::memory_order_acquire))
+#define portEXIT_CRITICAL(mux) (mux)->isLocked.clear(std::memory_order_release)
+#define portENTER_CRITICAL_ISR portENTER_CRITICAL
+#define portEXIT_CRITICAL_ISR portEXIT_CRITICAL
@@ -0,0 +1,30 @@
+#pragma once
+
+// Host side controls of the native build: virtual clock, fake HTTP responses
+// and access to the simulated panel. Firmware code never includes this.
+
+#include <Arduino.h>
+#include <time.h>
+
+// **Clock**
+// Virtual time starts at 0 and moves only through delay(), vTaskDelay() and
+// idle waits of the loop task. Other tasks run until they block again before
+// it moves on, so a run is deterministic.
+int64_t NativeClockMicros();
+void NativeClockSetEpoch(time_t utc); // wall clock (UTC) at the current virtual time
+void NativeClockAdvance(int64_t micros); // fires due esp_timers and wakes tasks on the way
+
+// **HTTP**
+// Requests whose URL contains urlPart get this response, unmatched URLs fail to connect
+void NativeHttpServe(const char *urlPart, const String &body, int code = 200);
+uint32_t NativeHttpRequests();
+
+// **Panel**
+const uint16_t *NativePanelPixels(); // what the display shows, RGB565 in SPI byte order like sprite memory
+int16_t NativePanelWidth();
+int16_t NativePanelHeight();
+uint32_t NativePanelWrites(); // increases on every pixel write to the panel
+
+bool NativeWritePpm(const char *path, const uint16_t *pixels, int16_t width, int16_t height);
+int32_t NativeComparePpm(const char *path, const uint16_t *pixels, int16_t width, int16_t height); // differing pixels, -1 if unreadable
+uint64_t NativeHashPixels(const uint16_t *pixels, int16_t width, int16_t height); // FNV-1a over the RGB of each pixel
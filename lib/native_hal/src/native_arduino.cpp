@@ -0,0 +1,115 @@
+#include <Arduino.h>
+#include <chrono>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// **Print**
+size_t Print::printf(const char *format, ...)
+{
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (length < 0)
+    return 0;
+  if (length < (int)sizeof(buf))
+    return write(buf, length);
+
+  std::string big(length + 1, '\0');
+  va_start(args, format);
+  vsnprintf(&big[0], big.size(), format, args);
+  va_end(args);
+  return write(big.data(), length);
+}
+
+// **Serial**
+size_t HardwareSerial::write(uint8_t c)
+{
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  return fwrite(buffer, 1, size, stdout);
+}
+
+// bytes that do not fit the driver buffer are lost, like a UART overrun
+size_t HardwareSerial::Inject(const uint8_t *data, size_t size)
+{
+  if (rxPos == rx.size())
+  {
+    rx.clear();
+    rxPos = 0;
+  }
+
+  size_t space = rxBufferSize - available();
+  size_t accepted = min(size, space);
+  rx.append((const char *)data, accepted);
+  if (accepted < size && onErrorCallback)
+    onErrorCallback(UART_BUFFER_FULL_ERROR);
+  if (accepted > 0 && onReceiveCallback)
+    onReceiveCallback();
+  return accepted;
+}
+
+// **ESP**
+// the host has no heap limit worth reporting, these are fixed
+uint32_t EspClass::getFreeHeap()
+{
+  return 200000;
+}
+
+uint32_t EspClass::getMinFreeHeap()
+{
+  return 200000;
+}
+
+uint32_t EspClass::getMaxAllocHeap()
+{
+  return 110000;
+}
+
+uint32_t EspClass::getHeapSize()
+{
+  return 320000;
+}
+
+// real host time at 240 MHz, so cycle based measurements time the host code
+uint32_t EspClass::getCycleCount()
+{
+  static const auto start = std::chrono::steady_clock::now();
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  return (uint64_t)elapsed.count() * 240 / 1000;
+}
+
+void EspClass::restart()
+{
+  printf("[NATIVE] ESP.restart()\n");
+  exit(0);
+}
+
+long random(long max)
+{
+  return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max)
+{
+  return max > min ? min + random(max - min) : min;
+}
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t length = strlen(src);
+  if (size > 0)
+  {
+    size_t copied = min(length, size - 1);
+    memcpy(dst, src, copied);
+    dst[copied] = '\0';
+  }
+  return length;
+}
+#endif
@@ -0,0 +1,276 @@
+// Entry point of the native build: runs the firmware setup()/loop() against
+// the host stand-ins, feeds serial input and HTTP responses from files, and
+// dumps or checks the panel after every loop pass.
+//
+//   program [--frames N] [--start "YYYY-MM-DD HH:MM:SS"] [--serial FILE]
+//           [--http MATCH=FILE]... [--dump DIR] [--golden DIR] [--bench]
+
+#include <Arduino.h>
+#include <chrono>
+#include <esp_timer.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include "native.h"
+
+#define NATIVE_SERIAL_CHUNK 256 // bytes per receive event, about one UART FIFO burst
+#define NATIVE_SERIAL_BITS 10   // start, 8 data and stop bit on the wire per byte
+#define NATIVE_HASH_FILE "frames.txt"
+
+struct NativeOptions
+{
+  uint32_t frames = 60;
+  const char *serialPath = nullptr;
+  const char *dumpDir = nullptr;
+  const char *goldenDir = nullptr;
+  bool isBench = false;
+};
+
+static bool ReadFile(const char *path, std::string &content)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    fprintf(stderr, "[NATIVE] cannot read %s\n", path);
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  content = buffer.str();
+  return true;
+}
+
+// bytes of the --serial file due at a virtual time
+struct SerialSegment
+{
+  int64_t atMicros;
+  std::string bytes;
+};
+
+struct SerialFeed
+{
+  std::vector<SerialSegment> segments;
+  size_t segment = 0;
+  size_t pos = 0;
+  esp_timer_handle_t timer = nullptr;
+};
+
+// a line of only "@<ms>" at the start of the file or after a newline times the
+// bytes after it, in ms since boot; bytes before the first one are due at 0
+static void ParseSerial(const std::string &input, std::vector<SerialSegment> &segments)
+{
+  segments.push_back({0, ""});
+  size_t pos = 0;
+  while (pos < input.size())
+  {
+    size_t lineEnd = input.find('\n', pos);
+    size_t end = lineEnd == std::string::npos ? input.size() : lineEnd + 1;
+    std::string line = input.substr(pos, end - pos);
+    pos = end;
+
+    size_t digitsEnd = line.find_first_not_of("0123456789", 1);
+    std::string rest = digitsEnd == std::string::npos ? "" : line.substr(digitsEnd);
+    if (line[0] != '@' || digitsEnd == 1 || !(rest.empty() || rest == "\n" || rest == "\r\n"))
+    {
+      segments.back().bytes += line;
+      continue;
+    }
+    int64_t atMicros = strtoll(line.c_str() + 1, nullptr, 10) * 1000;
+    if (segments.back().bytes.empty())
+      segments.back().atMicros = atMicros;
+    else
+      segments.push_back({atMicros, ""});
+  }
+}
+
+// one receive event per call like the UART driver, the next after the chunk's
+// wire time or at the next segment's time; what the RX buffer cannot take is
+// lost as on the device
+static void FeedSerial(void *arg)
+{
+  SerialFeed &feed = *(SerialFeed *)arg;
+  const std::string &bytes = feed.segments[feed.segment].bytes;
+  size_t chunk = min(bytes.size() - feed.pos, (size_t)NATIVE_SERIAL_CHUNK);
+  Serial.Inject((const uint8_t *)bytes.data() + feed.pos, chunk);
+  feed.pos += chunk;
+
+  int64_t waitMicros = Serial.baudRate() ? chunk * NATIVE_SERIAL_BITS * 1000000LL / Serial.baudRate() : 0;
+  if (feed.pos == bytes.size())
+  {
+    feed.segment++;
+    feed.pos = 0;
+    if (feed.segment == feed.segments.size())
+      return;
+    waitMicros = max(waitMicros, feed.segments[feed.segment].atMicros - NativeClockMicros());
+  }
+  esp_timer_start_once(feed.timer, waitMicros);
+}
+
+static bool ParseOptions(int argc, char **argv, NativeOptions &options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (arg == "--bench")
+    {
+      options.isBench = true;
+      continue;
+    }
+    if (value == nullptr)
+    {
+      fprintf(stderr, "[NATIVE] %s needs a value\n", arg.c_str());
+      return false;
+    }
+    i++;
+
+    if (arg == "--frames")
+      options.frames = strtoul(value, nullptr, 10);
+    else if (arg == "--serial")
+      options.serialPath = value;
+    else if (arg == "--dump")
+      options.dumpDir = value;
+    else if (arg == "--golden")
+      options.goldenDir = value;
+    else if (arg == "--start")
+    {
+      struct tm start = {};
+      if (strptime(value, "%Y-%m-%d %H:%M:%S", &start) == nullptr)
+      {
+        fprintf(stderr, "[NATIVE] bad --start %s\n", value);
+        return false;
+      }
+      NativeClockSetEpoch(timegm(&start));
+    }
+    else if (arg == "--http")
+    {
+      const char *split = strchr(value, '=');
+      std::string body;
+      if (split == nullptr || !ReadFile(split + 1, body))
+      {
+        fprintf(stderr, "[NATIVE] bad --http %s\n", value);
+        return false;
+      }
+      NativeHttpServe(std::string(value, split - value).c_str(), String(body.c_str()));
+    }
+    else
+    {
+      fprintf(stderr, "[NATIVE] unknown option %s\n", arg.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  NativeOptions options;
+  if (!ParseOptions(argc, argv, options))
+    return 2;
+
+  SerialFeed serialFeed;
+  if (options.serialPath != nullptr)
+  {
+    std::string serialInput;
+    if (!ReadFile(options.serialPath, serialInput))
+      return 2;
+    ParseSerial(serialInput, serialFeed.segments);
+  }
+
+  // golden frames are PPM files, or hashes in NATIVE_HASH_FILE where there is no PPM
+  std::map<std::string, uint64_t> goldenHashes;
+  if (options.goldenDir != nullptr)
+  {
+    std::ifstream file(std::string(options.goldenDir) + "/" NATIVE_HASH_FILE);
+    std::string name, hash;
+    while (file >> name >> hash)
+      goldenHashes[name] = strtoull(hash.c_str(), nullptr, 16);
+  }
+  FILE *hashFile = nullptr;
+  if (options.dumpDir != nullptr)
+  {
+    hashFile = fopen((std::string(options.dumpDir) + "/" NATIVE_HASH_FILE).c_str(), "w");
+  }
+
+  setup();
+
+  if (!serialFeed.segments.empty())
+  {
+    esp_timer_create_args_t args = {};
+    args.callback = FeedSerial;
+    args.arg = &serialFeed;
+    args.name = "serial feed";
+    esp_timer_create(&args, &serialFeed.timer);
+    esp_timer_start_once(serialFeed.timer, max<int64_t>(serialFeed.segments[0].atMicros - NativeClockMicros(), 0));
+  }
+
+  uint32_t lastWrites = NativePanelWrites();
+  uint32_t dumpedFrames = 0;
+  uint32_t mismatchedFrames = 0;
+  int64_t loopMicrosTotal = 0;
+  int64_t loopMicrosMax = 0;
+  for (uint32_t frame = 0; frame < options.frames; frame++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    loop();
+    int64_t loopMicros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    loopMicrosTotal += loopMicros;
+    loopMicrosMax = max(loopMicrosMax, loopMicros);
+
+    // only passes that changed the panel produce a frame
+    if (NativePanelWrites() == lastWrites)
+      continue;
+    lastWrites = NativePanelWrites();
+
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%04u.ppm", dumpedFrames++);
+    uint64_t hash = NativeHashPixels(NativePanelPixels(), NativePanelWidth(), NativePanelHeight());
+    if (options.dumpDir != nullptr)
+    {
+      std::string path = std::string(options.dumpDir) + "/" + name;
+      NativeWritePpm(path.c_str(), NativePanelPixels(), NativePanelWidth(), NativePanelHeight());
+      if (hashFile != nullptr)
+        fprintf(hashFile, "%s %016llx\n", name, (unsigned long long)hash);
+    }
+    if (options.goldenDir != nullptr)
+    {
+      std::string path = std::string(options.goldenDir) + "/" + name;
+      int32_t differing = NativeComparePpm(path.c_str(), NativePanelPixels(), NativePanelWidth(), NativePanelHeight());
+      auto golden = goldenHashes.find(name);
+      if (differing < 0 && golden != goldenHashes.end())
+      {
+        if (golden->second != hash)
+        {
+          fprintf(stderr, "[NATIVE] %s: hash %016llx, golden %016llx\n", name, (unsigned long long)hash, (unsigned long long)golden->second);
+          mismatchedFrames++;
+        }
+      }
+      else if (differing != 0)
+      {
+        fprintf(stderr, "[NATIVE] %s: %d pixels differ\n", name, differing);
+        mismatchedFrames++;
+      }
+    }
+  }
+  if (hashFile != nullptr)
+    fclose(hashFile);
+
+  printf("[NATIVE] passes: %u, frames: %u, virtual time: %.3f s, http requests: %u\n",
+         options.frames, dumpedFrames, NativeClockMicros() / 1e6, NativeHttpRequests());
+  if (options.isBench && options.frames > 0)
+  {
+    printf("[NATIVE] loop() host time: avg %lld us, max %lld us\n",
+           (long long)(loopMicrosTotal / options.frames), (long long)loopMicrosMax);
+  }
+  if (options.goldenDir != nullptr)
+  {
+    // a run that stops short of the golden frames differs as well
+    mismatchedFrames += goldenHashes.size() > dumpedFrames ? goldenHashes.size() - dumpedFrames : 0;
+    printf("[NATIVE] golden frames: %u of %u differ\n", mismatchedFrames, max<uint32_t>(dumpedFrames, goldenHashes.size()));
+  }
+
+  // tasks are still blocked in the simulated kernel, skip static destructors
+  fflush(stdout);
+  _Exit(mismatchedFrames > 0 ? 1 : 0);
+}
@@ -0,0 +1,84 @@
+#include <Preferences.h>
+#include <map>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t>> NativeNamespace;
+
+static std::map<std::string, NativeNamespace> storage;
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partitionLabel)
+{
+  if (isOpen)
+    return false;
+  // like NVS, a read-only open of a namespace that was never written fails
+  if (readOnly && storage.find(name) == storage.end())
+    return false;
+
+  this->name = name;
+  storage[name];
+  isOpen = true;
+  isReadOnly = readOnly;
+  return true;
+}
+
+void Preferences::end()
+{
+  isOpen = false;
+}
+
+bool Preferences::clear()
+{
+  if (!isOpen || isReadOnly)
+    return false;
+  storage[name].clear();
+  return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+  if (!isOpen || isReadOnly)
+    return false;
+  return storage[name].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char *key)
+{
+  return isOpen && storage[name].count(key) > 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length)
+{
+  if (!isOpen || isReadOnly || key == nullptr || value == nullptr)
+    return 0;
+  const uint8_t *bytes = (const uint8_t *)value;
+  storage[name][key].assign(bytes, bytes + length);
+  return length;
+}
+
+String Preferences::getString(const char *key, const String &defaultValue)
+{
+  size_t length = getBytesLength(key);
+  if (length == 0)
+    return defaultValue;
+  std::vector<char> buffer(length);
+  getBytes(key, buffer.data(), length);
+  return String(buffer.data());
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+  if (!isOpen)
+    return 0;
+  NativeNamespace &values = storage[name];
+  auto it = values.find(key);
+  return it == values.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t maxLength)
+{
+  size_t length = getBytesLength(key);
+  if (length == 0 || length > maxLength)
+    return 0;
+  memcpy(buffer, storage[name][key].data(), length);
+  return length;
+}
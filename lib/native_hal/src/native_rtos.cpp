@@ -0,0 +1,505 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "native.h"
+
+// One lock guards all task, queue and timer state. The loop task (main
+// thread) is the scheduler: it moves virtual time forward only when every
+// other task is blocked, and fires timers and timeouts in deadline order.
+
+#define NATIVE_NEVER INT64_MAX
+#define NATIVE_QUIESCE_TIMEOUT_MS 5000 // real time, a task that never blocks is reported instead of hanging
+
+struct NativeTask
+{
+  std::string name;
+  uint32_t stackDepth = 0;
+  std::condition_variable wake;
+  bool isBlocked = false;
+  bool isFinished = false;
+  int64_t deadline = NATIVE_NEVER;
+  const void *waitingOn = nullptr;
+  uint32_t notifyValue = 0;
+  bool isNotified = false;
+};
+
+struct NativeQueue
+{
+  size_t itemSize;
+  size_t length;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+struct NativeTimer
+{
+  esp_timer_cb_t callback;
+  void *arg;
+  int64_t deadline;
+  int64_t period;
+  bool isArmed;
+};
+
+static std::mutex rtosMutex;
+static std::condition_variable idleChanged;
+static std::atomic<int64_t> clockMicros{0};
+static time_t clockEpoch = 1736125200; // 2025-01-06 01:00:00 UTC, Monday 09:00 in Taipei
+static long gmtOffset = 0;
+static int runnableWorkers = 0;
+static std::vector<NativeTask *> tasks;
+static std::vector<NativeTimer *> timers;
+static NativeTask mainTask = NativeTask{"loopTask", 8192, {}};
+static thread_local NativeTask *currentTask = &mainTask;
+
+static bool IsMainTask()
+{
+  return currentTask == &mainTask;
+}
+
+static void Wake(NativeTask *task)
+{
+  if (task->isBlocked && !task->isFinished)
+  {
+    task->isBlocked = false;
+    runnableWorkers++;
+    task->wake.notify_one();
+  }
+}
+
+static void WakeWaiters(const void *object)
+{
+  for (NativeTask *task : tasks)
+  {
+    if (task->waitingOn == object)
+      Wake(task);
+  }
+}
+
+// main thread: let woken tasks run until all of them block again
+static void Quiesce(std::unique_lock<std::mutex> &lock)
+{
+  if (!idleChanged.wait_for(lock, std::chrono::milliseconds(NATIVE_QUIESCE_TIMEOUT_MS), []
+                            { return runnableWorkers == 0; }))
+  {
+    printf("[NATIVE] a task did not block within %d ms, continuing\n", NATIVE_QUIESCE_TIMEOUT_MS);
+  }
+}
+
+static int64_t NextEvent()
+{
+  int64_t next = NATIVE_NEVER;
+  for (NativeTimer *timer : timers)
+  {
+    if (timer->isArmed)
+      next = min(next, timer->deadline);
+  }
+  for (NativeTask *task : tasks)
+  {
+    if (task->isBlocked)
+      next = min(next, task->deadline);
+  }
+  return next;
+}
+
+// set the clock to the next event and handle it: a timer callback or a task timeout
+static void FireNextEvent(std::unique_lock<std::mutex> &lock, int64_t at)
+{
+  clockMicros = max(clockMicros.load(), at);
+  for (NativeTimer *timer : timers)
+  {
+    if (timer->isArmed && timer->deadline <= at)
+    {
+      if (timer->period > 0)
+        timer->deadline += timer->period;
+      else
+        timer->isArmed = false;
+      lock.unlock();
+      timer->callback(timer->arg);
+      lock.lock();
+      return;
+    }
+  }
+  for (NativeTask *task : tasks)
+  {
+    if (task->isBlocked && task->deadline <= at)
+    {
+      Wake(task);
+      return;
+    }
+  }
+}
+
+// main thread: run the simulation until ready() or the virtual deadline, false on timeout
+static bool MainWait(std::unique_lock<std::mutex> &lock, const std::function<bool()> &ready, int64_t deadline)
+{
+  while (true)
+  {
+    Quiesce(lock);
+    if (ready())
+      return true;
+
+    int64_t next = NextEvent();
+    if (next > deadline)
+    {
+      if (deadline != NATIVE_NEVER)
+        clockMicros = max(clockMicros.load(), deadline);
+      return false;
+    }
+    if (next == NATIVE_NEVER)
+    {
+      return false; // nothing could ever make it ready
+    }
+    FireNextEvent(lock, next);
+  }
+}
+
+// other tasks: block until woken and ready(), false once the virtual deadline passed
+static bool WorkerWait(std::unique_lock<std::mutex> &lock, const void *object, const std::function<bool()> &ready, int64_t deadline)
+{
+  NativeTask *task = currentTask;
+  while (!ready())
+  {
+    if (clockMicros >= deadline)
+      return false;
+    task->isBlocked = true;
+    task->deadline = deadline;
+    task->waitingOn = object;
+    runnableWorkers--;
+    idleChanged.notify_all();
+    task->wake.wait(lock, [task]
+                    { return !task->isBlocked; });
+    task->deadline = NATIVE_NEVER;
+    task->waitingOn = nullptr;
+  }
+  return true;
+}
+
+static bool Wait(std::unique_lock<std::mutex> &lock, const void *object, const std::function<bool()> &ready, TickType_t ticks)
+{
+  int64_t deadline = ticks == portMAX_DELAY ? NATIVE_NEVER : clockMicros + ticks * 1000LL;
+  return IsMainTask() ? MainWait(lock, ready, deadline) : WorkerWait(lock, object, ready, deadline);
+}
+
+// after the loop task signalled another task, run that task first so results do not depend on host timing
+static void AfterSignal(std::unique_lock<std::mutex> &lock)
+{
+  if (IsMainTask())
+    Quiesce(lock);
+}
+
+// **Clock**
+int64_t NativeClockMicros()
+{
+  return clockMicros;
+}
+
+void NativeClockSetEpoch(time_t utc)
+{
+  clockEpoch = utc - clockMicros / 1000000;
+}
+
+void NativeClockAdvance(int64_t micros)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  int64_t deadline = clockMicros + micros;
+  if (IsMainTask())
+    MainWait(lock, []
+             { return false; }, deadline);
+  else
+    WorkerWait(lock, nullptr, []
+               { return false; }, deadline);
+}
+
+unsigned long millis()
+{
+  return clockMicros / 1000;
+}
+
+unsigned long micros()
+{
+  return clockMicros;
+}
+
+void delay(uint32_t ms)
+{
+  NativeClockAdvance(ms * 1000LL);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+  NativeClockAdvance(us);
+}
+
+void yield()
+{
+}
+
+int64_t esp_timer_get_time()
+{
+  return clockMicros;
+}
+
+extern "C" int __wrap_gettimeofday(struct timeval *tv, void *tz)
+{
+  int64_t now = clockEpoch * 1000000LL + clockMicros;
+  tv->tv_sec = now / 1000000;
+  tv->tv_usec = now % 1000000;
+  return 0;
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char *server1, const char *server2, const char *server3)
+{
+  gmtOffset = gmtOffsetSec + daylightOffsetSec;
+}
+
+bool getLocalTime(struct tm *info, uint32_t ms)
+{
+  time_t now = clockEpoch + clockMicros / 1000000 + gmtOffset;
+  gmtime_r(&now, info);
+  return true;
+}
+
+// **Tasks**
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameters,
+                                   UBaseType_t priority, TaskHandle_t *createdTask, BaseType_t coreId)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  NativeTask *task = new NativeTask();
+  task->name = name;
+  task->stackDepth = stackDepth;
+  tasks.push_back(task);
+  runnableWorkers++;
+  if (createdTask != nullptr)
+    *createdTask = task;
+
+  std::thread([task, function, parameters]()
+              {
+                currentTask = task;
+                function(parameters);
+                std::unique_lock<std::mutex> lock(rtosMutex);
+                task->isBlocked = true;
+                task->isFinished = true; // returned, never runnable again
+                runnableWorkers--;
+                idleChanged.notify_all(); })
+      .detach();
+  AfterSignal(lock);
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameters,
+                       UBaseType_t priority, TaskHandle_t *createdTask)
+{
+  return xTaskCreatePinnedToCore(function, name, stackDepth, parameters, priority, createdTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+  if (task == nullptr && !IsMainTask())
+  {
+    // a task deleting itself just never wakes up again
+    std::unique_lock<std::mutex> lock(rtosMutex);
+    WorkerWait(lock, nullptr, []
+               { return false; }, NATIVE_NEVER);
+  }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  NativeClockAdvance(ticks * 1000LL);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+  return currentTask;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+  return (task != nullptr ? task : currentTask)->name.c_str();
+}
+
+// the host cannot see the stack depth used, report the configured size as untouched
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+  return (task != nullptr ? task : currentTask)->stackDepth;
+}
+
+TickType_t xTaskGetTickCount()
+{
+  return clockMicros / 1000;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  switch (action)
+  {
+  case eSetBits:
+    task->notifyValue |= value;
+    break;
+  case eIncrement:
+    task->notifyValue++;
+    break;
+  case eSetValueWithOverwrite:
+    task->notifyValue = value;
+    break;
+  case eSetValueWithoutOverwrite:
+    if (task->isNotified)
+      return pdFAIL;
+    task->notifyValue = value;
+    break;
+  case eNoAction:
+    break;
+  }
+  task->isNotified = true;
+  Wake(task);
+  if (task != currentTask)
+    AfterSignal(lock);
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  NativeTask *task = currentTask;
+  if (!task->isNotified)
+    task->notifyValue &= ~clearOnEntry;
+
+  bool isReceived = Wait(lock, task, [task]
+                         { return task->isNotified; }, ticks);
+  if (value != nullptr)
+    *value = task->notifyValue;
+  if (isReceived)
+  {
+    task->notifyValue &= ~clearOnExit;
+    task->isNotified = false;
+  }
+  return isReceived ? pdTRUE : pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  NativeTask *task = currentTask;
+  Wait(lock, task, [task]
+       { return task->notifyValue != 0; }, ticks);
+  uint32_t value = task->notifyValue;
+  if (value != 0)
+    task->notifyValue = clearOnExit ? 0 : value - 1;
+  task->isNotified = false;
+  return value;
+}
+
+// **Queues**
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+  NativeQueue *queue = new NativeQueue();
+  queue->itemSize = itemSize;
+  queue->length = length;
+  return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+  delete queue;
+}
+
+static BaseType_t QueueSend(QueueHandle_t queue, const void *item, TickType_t ticks, bool isFront)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  if (!Wait(lock, queue, [queue]
+            { return queue->items.size() < queue->length; }, ticks))
+  {
+    return pdFALSE;
+  }
+
+  std::vector<uint8_t> copy((const uint8_t *)item, (const uint8_t *)item + queue->itemSize);
+  if (isFront)
+    queue->items.push_front(copy);
+  else
+    queue->items.push_back(copy);
+  WakeWaiters(queue);
+  AfterSignal(lock);
+  return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+  return QueueSend(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+  return QueueSend(queue, item, ticks, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  if (!Wait(lock, queue, [queue]
+            { return !queue->items.empty(); }, ticks))
+  {
+    return pdFALSE;
+  }
+
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  WakeWaiters(queue);
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  return queue->items.size();
+}
+
+// **esp_timer**
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  NativeTimer *timer = new NativeTimer{args->callback, args->arg, 0, 0, false};
+  timers.push_back(timer);
+  *handle = timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  timer->deadline = clockMicros + timeoutUs;
+  timer->period = 0;
+  timer->isArmed = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodUs)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  timer->deadline = clockMicros + periodUs;
+  timer->period = periodUs;
+  timer->isArmed = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  bool wasArmed = timer->isArmed;
+  timer->isArmed = false;
+  return wasArmed ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+  std::unique_lock<std::mutex> lock(rtosMutex);
+  timers.erase(std::remove(timers.begin(), timers.end(), timer), timers.end());
+  delete timer;
+  return ESP_OK;
+}
@@ -0,0 +1,609 @@
+#include <TFT_eSPI.h>
+#include "native.h"
+
+static TFT_eSPI *panel = nullptr;
+static uint32_t panelWrites = 0;
+
+static uint16_t SwapBytes(uint16_t color)
+{
+  return color << 8 | color >> 8;
+}
+
+static uint32_t ReadInt32(const uint8_t *p)
+{
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+// **Built-in font metrics**
+// heights and widths close to the GLCD and RLE fonts of TFT_eSPI
+static int16_t BuiltinHeight(uint8_t font)
+{
+  switch (font)
+  {
+  case 2:
+    return 16;
+  case 4:
+    return 26;
+  case 6:
+  case 7:
+    return 48;
+  case 8:
+    return 75;
+  default:
+    return 8;
+  }
+}
+
+// seven segment layout of a 32x48 font 7 cell: x, y, w, h of segments a..g
+static const int8_t segmentRects[7][4] = {
+    {7, 0, 18, 5},  // a
+    {25, 5, 5, 18}, // b
+    {25, 26, 5, 17}, // c
+    {7, 43, 18, 5}, // d
+    {2, 26, 5, 17}, // e
+    {2, 5, 5, 18},  // f
+    {7, 21, 18, 5}, // g
+};
+static const uint8_t digitSegments[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+
+// **Panel and sprite**
+TFT_eSPI::TFT_eSPI(int16_t width, int16_t height)
+    : TFT_eSPI(width, height, true)
+{
+  panel = this;
+}
+
+TFT_eSPI::TFT_eSPI(int16_t width, int16_t height, bool isPanel)
+    : _width(width), _height(height), isPanel(isPanel)
+{
+  pixels.assign(width * height, 0);
+}
+
+void TFT_eSPI::init(uint8_t tc)
+{
+  rotation = 0;
+  Resize(TFT_WIDTH, TFT_HEIGHT);
+}
+
+void TFT_eSPI::setRotation(uint8_t r)
+{
+  rotation = r % 4;
+  if (rotation & 1)
+    Resize(TFT_HEIGHT, TFT_WIDTH);
+  else
+    Resize(TFT_WIDTH, TFT_HEIGHT);
+}
+
+void TFT_eSPI::Resize(int16_t width, int16_t height)
+{
+  if (width != _width || height != _height || pixels.size() != (size_t)(width * height))
+  {
+    _width = width;
+    _height = height;
+    pixels.assign(width * height, 0);
+  }
+}
+
+void TFT_eSPI::setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool datum)
+{
+  vpX = x;
+  vpY = y;
+  vpW = w;
+  vpH = h;
+  vpDatum = datum;
+}
+
+void TFT_eSPI::resetViewport()
+{
+  setViewport(0, 0, INT16_MAX, INT16_MAX);
+}
+
+void TFT_eSPI::WritePixel(int32_t x, int32_t y, uint16_t color)
+{
+  if (vpDatum)
+  {
+    x += vpX;
+    y += vpY;
+  }
+  if (x < vpX || y < vpY || x >= vpX + vpW || y >= vpY + vpH)
+    return;
+  if (x < 0 || y < 0 || x >= _width || y >= _height)
+    return;
+  pixels[y * _width + x] = SwapBytes(color);
+  if (isPanel)
+    panelWrites++;
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color)
+{
+  WritePixel(x, y, color);
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y)
+{
+  if (x < 0 || y < 0 || x >= _width || y >= _height)
+    return 0;
+  return SwapBytes(pixels[y * _width + x]);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color)
+{
+  fillRect(x, y, w, 1, color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color)
+{
+  fillRect(x, y, 1, h, color);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+  for (int32_t row = y; row < y + h; row++)
+    for (int32_t col = x; col < x + w; col++)
+      WritePixel(col, row, color);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y, h, color);
+  drawFastVLine(x + w - 1, y, h, color);
+}
+
+void TFT_eSPI::fillScreen(uint32_t color)
+{
+  fillRect(0, 0, _width, _height, color);
+}
+
+// data is in SPI byte order unless setSwapBytes(true), as on the device
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data)
+{
+  for (int32_t row = 0; row < h; row++)
+  {
+    for (int32_t col = 0; col < w; col++)
+    {
+      uint16_t pixel = data[row * w + col];
+      WritePixel(x + col, y + row, swapBytes ? pixel : SwapBytes(pixel));
+    }
+  }
+}
+
+TFT_eSprite::TFT_eSprite(TFT_eSPI *tft)
+    : TFT_eSPI(0, 0, false), parent(tft)
+{
+}
+
+void *TFT_eSprite::createSprite(int16_t width, int16_t height, uint8_t frames)
+{
+  if (!isCreated)
+  {
+    Resize(width, height);
+    isCreated = true;
+  }
+  return pixels.data();
+}
+
+void TFT_eSprite::deleteSprite()
+{
+  pixels.clear();
+  pixels.shrink_to_fit();
+  _width = _height = 0;
+  isCreated = false;
+}
+
+void *TFT_eSprite::setColorDepth(int8_t bits)
+{
+  return getPointer();
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y)
+{
+  pushSprite(x, y, 0, 0, _width, _height);
+}
+
+// both buffers are in SPI byte order, rows copy as is
+bool TFT_eSprite::pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh)
+{
+  if (!isCreated || parent == nullptr)
+    return false;
+
+  for (int32_t row = 0; row < sh; row++)
+  {
+    int32_t srcY = sy + row;
+    int32_t dstY = ty + row;
+    if (srcY < 0 || srcY >= _height || dstY < 0 || dstY >= parent->_height)
+      continue;
+    for (int32_t col = 0; col < sw; col++)
+    {
+      int32_t srcX = sx + col;
+      int32_t dstX = tx + col;
+      if (srcX < 0 || srcX >= _width || dstX < 0 || dstX >= parent->_width)
+        continue;
+      parent->pixels[dstY * parent->_width + dstX] = pixels[srcY * _width + srcX];
+      if (parent->isPanel)
+        panelWrites++;
+    }
+  }
+  return true;
+}
+
+bool TFT_eSprite::pushToSprite(TFT_eSprite *dst, int32_t x, int32_t y)
+{
+  if (!isCreated || dst == nullptr || !dst->isCreated)
+    return false;
+  dst->pushImage(x, y, _width, _height, (const uint16_t *)pixels.data());
+  return true;
+}
+
+// **Text**
+void TFT_eSPI::setTextColor(uint16_t color)
+{
+  textColor = textBgColor = color;
+}
+
+void TFT_eSPI::setTextColor(uint16_t fg, uint16_t bg, bool bgFill)
+{
+  textColor = fg;
+  textBgColor = bg;
+}
+
+void TFT_eSPI::setCursor(int16_t x, int16_t y)
+{
+  cursorX = x;
+  cursorY = y;
+}
+
+int16_t TFT_eSPI::BuiltinCharWidth(uint16_t c, uint8_t font)
+{
+  bool isDigit = c >= '0' && c <= '9';
+  switch (font)
+  {
+  case 2:
+    return c == ' ' ? 4 : 7;
+  case 4:
+    return c == ' ' ? 8 : 14;
+  case 6:
+    return isDigit ? 27 : 14;
+  case 7:
+    return isDigit ? 32 : 12;
+  case 8:
+    return isDigit ? 55 : 27;
+  default:
+    return 6;
+  }
+}
+
+// background is filled only when it differs from the foreground, like the RLE fonts
+int16_t TFT_eSPI::DrawBuiltinChar(uint16_t c, int32_t x, int32_t y, uint8_t font)
+{
+  int16_t width = BuiltinCharWidth(c, font);
+  int16_t height = BuiltinHeight(font);
+  if (textBgColor != textColor)
+    fillRect(x, y, width, height, textBgColor);
+
+  if (font == 7)
+  {
+    if (c >= '0' && c <= '9')
+    {
+      for (uint8_t s = 0; s < 7; s++)
+      {
+        if (digitSegments[c - '0'] & (1 << s))
+          fillRect(x + segmentRects[s][0], y + segmentRects[s][1], segmentRects[s][2], segmentRects[s][3], textColor);
+      }
+    }
+    else if (c == ':')
+    {
+      fillRect(x + 4, y + 14, 5, 5, textColor);
+      fillRect(x + 4, y + 30, 5, 5, textColor);
+    }
+    else if (c == '.')
+      fillRect(x + 4, y + 43, 5, 5, textColor);
+    else if (c == '-')
+      fillRect(x + 1, y + 21, 10, 5, textColor);
+    return width;
+  }
+
+  if (c > ' ' && c < 0x7F)
+    drawRect(x, y, width - 1, height - 1, textColor);
+  return width;
+}
+
+int16_t TFT_eSPI::DrawSmoothChar(uint16_t code, int32_t x, int32_t y)
+{
+  if (code < 0x21)
+    return gFont.spaceWidth;
+
+  uint16_t gNum;
+  if (!getUnicodeIndex(code, &gNum))
+  {
+    drawRect(x, y + gFont.maxAscent - gFont.ascent, gFont.spaceWidth, gFont.ascent, textColor);
+    return gFont.spaceWidth + 1;
+  }
+
+  const uint8_t *bitmap = gFont.gArray + gBitmap[gNum];
+  int32_t top = y + gFont.maxAscent - gdY[gNum];
+  int32_t left = x + gdX[gNum];
+  for (int32_t row = 0; row < gHeight[gNum]; row++)
+  {
+    for (int32_t col = 0; col < gWidth[gNum]; col++)
+    {
+      uint8_t alpha = bitmap[row * gWidth[gNum] + col];
+      if (alpha == 0)
+        continue;
+      WritePixel(left + col, top + row, alpha == 255 ? textColor : alphaBlend(alpha, textColor, textBgColor));
+    }
+  }
+  return gxAdvance[gNum];
+}
+
+int16_t TFT_eSPI::drawChar(uint16_t c, int32_t x, int32_t y, uint8_t font)
+{
+  if (fontLoaded)
+    return DrawSmoothChar(c, x, y);
+  return DrawBuiltinChar(c, x, y, font);
+}
+
+int16_t TFT_eSPI::drawString(const char *str, int32_t x, int32_t y, uint8_t font)
+{
+  uint16_t length = strlen(str);
+  uint16_t index = 0;
+  int32_t cursor = x;
+  while (index < length)
+  {
+    uint16_t code = fontLoaded ? decodeUTF8((uint8_t *)str, &index, length - index) : (uint8_t)str[index++];
+    cursor += drawChar(code, cursor, y, font);
+  }
+  return cursor - x;
+}
+
+int16_t TFT_eSPI::textWidth(const char *str, uint8_t font)
+{
+  uint16_t length = strlen(str);
+  uint16_t index = 0;
+  int16_t width = 0;
+  while (index < length)
+  {
+    if (!fontLoaded)
+    {
+      width += BuiltinCharWidth((uint8_t)str[index++], font);
+      continue;
+    }
+
+    uint16_t code = decodeUTF8((uint8_t *)str, &index, length - index);
+    uint16_t gNum;
+    if (code < 0x21)
+      width += gFont.spaceWidth;
+    else if (getUnicodeIndex(code, &gNum))
+      width += gxAdvance[gNum];
+    else
+      width += gFont.spaceWidth + 1;
+  }
+  return width;
+}
+
+int16_t TFT_eSPI::fontHeight(int16_t font)
+{
+  if (fontLoaded)
+    return gFont.yAdvance;
+  return BuiltinHeight(font);
+}
+
+size_t TFT_eSPI::write(uint8_t c)
+{
+  if (c == '\r')
+    return 1;
+  if (c == '\n')
+  {
+    cursorX = 0;
+    cursorY += fontHeight();
+    return 1;
+  }
+
+  int16_t width = fontLoaded ? textWidth(String((char)c).c_str(), textFont) : BuiltinCharWidth(c, textFont);
+  if (textWrapX && cursorX + width > _width)
+  {
+    cursorX = 0;
+    cursorY += fontHeight();
+  }
+  cursorX += drawChar(c, cursorX, cursorY, textFont);
+  return 1;
+}
+
+// **Smooth fonts**
+// same parsing and metrics as TFT_eSPI::loadMetrics()
+void TFT_eSPI::loadFont(const uint8_t array[])
+{
+  if (array == nullptr)
+    return;
+  unloadFont();
+
+  gFont.gArray = array;
+  gFont.gCount = ReadInt32(array);
+  gFont.yAdvance = ReadInt32(array + 8);
+  gFont.ascent = ReadInt32(array + 16);
+  gFont.descent = ReadInt32(array + 20);
+  gFont.spaceWidth = (gFont.ascent + gFont.descent) * 2 / 7;
+  gFont.maxAscent = gFont.ascent;
+  gFont.maxDescent = gFont.descent;
+
+  uint16_t count = gFont.gCount;
+  gUnicode = (uint16_t *)malloc(count * sizeof(uint16_t) + 1);
+  gHeight = (uint8_t *)malloc(count + 1);
+  gWidth = (uint8_t *)malloc(count + 1);
+  gxAdvance = (uint8_t *)malloc(count + 1);
+  gdY = (int16_t *)malloc(count * sizeof(int16_t) + 1);
+  gdX = (int8_t *)malloc(count + 1);
+  gBitmap = (uint32_t *)malloc(count * sizeof(uint32_t) + 1);
+
+  uint32_t bitmapPtr = 24 + count * 28;
+  for (uint16_t i = 0; i < count; i++)
+  {
+    const uint8_t *header = array + 24 + i * 28;
+    gUnicode[i] = ReadInt32(header);
+    gHeight[i] = ReadInt32(header + 4);
+    gWidth[i] = ReadInt32(header + 8);
+    gxAdvance[i] = ReadInt32(header + 12);
+    gdY[i] = ReadInt32(header + 16);
+    gdX[i] = ReadInt32(header + 20);
+    gBitmap[i] = bitmapPtr;
+    bitmapPtr += gWidth[i] * gHeight[i];
+
+    if ((gUnicode[i] > 0x20 && gUnicode[i] < 0x7F) || gUnicode[i] > 0xA0)
+    {
+      if (gdY[i] > (int16_t)gFont.maxAscent)
+        gFont.maxAscent = gdY[i];
+      if ((int16_t)gHeight[i] - gdY[i] > (int16_t)gFont.maxDescent)
+        gFont.maxDescent = gHeight[i] - gdY[i];
+    }
+  }
+  gFont.yAdvance = gFont.maxAscent + gFont.maxDescent;
+  fontLoaded = true;
+}
+
+void TFT_eSPI::unloadFont()
+{
+  free(gUnicode);
+  free(gHeight);
+  free(gWidth);
+  free(gxAdvance);
+  free(gdY);
+  free(gdX);
+  free(gBitmap);
+  gUnicode = nullptr;
+  gHeight = gWidth = gxAdvance = nullptr;
+  gdY = nullptr;
+  gdX = nullptr;
+  gBitmap = nullptr;
+  gFont.gArray = nullptr;
+  fontLoaded = false;
+}
+
+bool TFT_eSPI::getUnicodeIndex(uint16_t unicode, uint16_t *index)
+{
+  for (uint16_t i = 0; i < gFont.gCount; i++)
+  {
+    if (gUnicode[i] == unicode)
+    {
+      *index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint16_t TFT_eSPI::alphaBlend(uint8_t alpha, uint16_t fgc, uint16_t bgc)
+{
+  uint32_t rxb = bgc & 0xF81F;
+  rxb += ((fgc & 0xF81F) - rxb) * (alpha >> 2) >> 6;
+  uint32_t xgx = bgc & 0x07E0;
+  xgx += ((fgc & 0x07E0) - xgx) * alpha >> 8;
+  return (rxb & 0xF81F) | (xgx & 0x07E0);
+}
+
+uint16_t TFT_eSPI::decodeUTF8(uint8_t *buf, uint16_t *index, uint16_t remaining)
+{
+  uint16_t c = buf[(*index)++];
+  if ((c & 0x80) == 0x00)
+    return c;
+  if ((c & 0xE0) == 0xC0 && remaining > 1)
+    return (c & 0x1F) << 6 | (buf[(*index)++] & 0x3F);
+  if ((c & 0xF0) == 0xE0 && remaining > 2)
+  {
+    c = (c & 0x0F) << 12 | (buf[(*index)++] & 0x3F) << 6;
+    return c | (buf[(*index)++] & 0x3F);
+  }
+  return c;
+}
+
+// **Host access**
+const uint16_t *NativePanelPixels()
+{
+  return panel != nullptr ? panel->pixels.data() : nullptr;
+}
+
+int16_t NativePanelWidth()
+{
+  return panel != nullptr ? panel->_width : 0;
+}
+
+int16_t NativePanelHeight()
+{
+  return panel != nullptr ? panel->_height : 0;
+}
+
+uint32_t NativePanelWrites()
+{
+  return panelWrites;
+}
+
+static void PixelToRgb(uint16_t pixel, uint8_t *rgb)
+{
+  uint16_t color = SwapBytes(pixel);
+  rgb[0] = (color >> 11) * 255 / 31;
+  rgb[1] = (color >> 5 & 0x3F) * 255 / 63;
+  rgb[2] = (color & 0x1F) * 255 / 31;
+}
+
+bool NativeWritePpm(const char *path, const uint16_t *pixels, int16_t width, int16_t height)
+{
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr)
+    return false;
+
+  fprintf(file, "P6\n%d %d\n255\n", width, height);
+  for (int32_t i = 0; i < width * height; i++)
+  {
+    uint8_t rgb[3];
+    PixelToRgb(pixels[i], rgb);
+    fwrite(rgb, 1, 3, file);
+  }
+  return fclose(file) == 0;
+}
+
+int32_t NativeComparePpm(const char *path, const uint16_t *pixels, int16_t width, int16_t height)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr)
+    return -1;
+
+  int fileWidth, fileHeight, maxValue;
+  if (fscanf(file, "P6 %d %d %d", &fileWidth, &fileHeight, &maxValue) != 3 ||
+      fileWidth != width || fileHeight != height || maxValue != 255 || fgetc(file) == EOF)
+  {
+    fclose(file);
+    return -1;
+  }
+
+  int32_t differing = 0;
+  for (int32_t i = 0; i < width * height; i++)
+  {
+    uint8_t expected[3], actual[3];
+    if (fread(expected, 1, 3, file) != 3)
+    {
+      fclose(file);
+      return -1;
+    }
+    PixelToRgb(pixels[i], actual);
+    if (memcmp(expected, actual, 3) != 0)
+      differing++;
+  }
+  fclose(file);
+  return differing;
+}
+
+uint64_t NativeHashPixels(const uint16_t *pixels, int16_t width, int16_t height)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int32_t i = 0; i < width * height; i++)
+  {
+    uint8_t rgb[3];
+    PixelToRgb(pixels[i], rgb);
+    for (uint8_t c : rgb)
+    {
+      hash ^= c;
+      hash *= 0x100000001b3ULL;
+    }
+  }
+  return hash;
+}
@@ -0,0 +1,254 @@
+#include "album_art.h"
+
+#define ALBUM_ART_PIXELS (ALBUM_ART_SIZE * ALBUM_ART_SIZE)
+
+static uint32_t GetU32(const uint8_t *p)
+{
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+AlbumArt::AlbumArt(TFT_eSPI *display)
+    : sprite(display)
+{
+}
+
+bool AlbumArt::Begin(Print &output, Print &logOutput)
+{
+  out = &output;
+  logOut = &logOutput;
+  sprite.setColorDepth(16);
+  if (sprite.createSprite(ALBUM_ART_SIZE, ALBUM_ART_SIZE) == nullptr)
+  {
+    return false;
+  }
+  cache = (uint16_t *)malloc(ALBUM_ART_CACHE_SLOTS * ALBUM_ART_PIXELS * sizeof(uint16_t));
+  return cache != nullptr; // without one every track is sent again
+}
+
+bool AlbumArt::Handle(const PlayerLinkFrame &frame)
+{
+  const uint8_t *p = (const uint8_t *)frame.payload.data;
+  if (frame.type != LinkBytes || frame.payload.length < 1 || !sprite.created())
+  {
+    return false;
+  }
+  screen = frame.screen; // answers go back to where the frame came from
+  field = frame.field;
+
+  switch (p[0])
+  {
+  case ALBUM_ART_OP_BEGIN:
+  {
+    bool wasShown = isShown;
+    HandleBegin(p + 1, frame.payload.length - 1);
+    return isShown || wasShown; // a cache hit shows at once, a transfer clears the old art
+  }
+  case ALBUM_ART_OP_CHUNK:
+    return HandleChunk(p + 1, frame.payload.length - 1);
+  case ALBUM_ART_OP_CLEAR:
+    isReceiving = false;
+    isShown = false;
+    return true;
+  }
+  return false;
+}
+
+TFT_eSprite *AlbumArt::Current()
+{
+  return isShown ? &sprite : nullptr;
+}
+
+const AlbumArtStats &AlbumArt::Stats()
+{
+  return stats;
+}
+
+void AlbumArt::HandleBegin(const uint8_t *p, uint16_t length)
+{
+  if (isReceiving)
+  {
+    stats.aborted++;
+  }
+  isReceiving = false;
+  isShown = false;
+  nextSeq = 0;
+  if (length < 11)
+  {
+    Reject();
+    return;
+  }
+  hash = GetU32(p);
+  size = GetU32(p + 7);
+  if (p[4] != ALBUM_ART_SIZE || p[5] != ALBUM_ART_SIZE || p[6] != ALBUM_ART_FORMAT_RLE565 || size == 0)
+  {
+    Reject();
+    return;
+  }
+
+  int8_t slot = Find(hash);
+  if (slot >= 0)
+  {
+    memcpy(sprite.getPointer(), cache + slot * ALBUM_ART_PIXELS, ALBUM_ART_PIXELS * sizeof(uint16_t));
+    cacheUsed[slot] = ++useCount;
+    isShown = true;
+    stats.cacheHits++;
+    Ack(ALBUM_ART_STATUS_HAVE);
+    return;
+  }
+
+  isReceiving = true;
+  pixelIndex = 0;
+  bytes = 0;
+  decodeMicros = 0;
+  state = ExpandHeader;
+  startMillis = millis();
+  Ack(ALBUM_ART_STATUS_SEND);
+}
+
+bool AlbumArt::HandleChunk(const uint8_t *p, uint16_t length)
+{
+  if (!isReceiving || length < 2)
+  {
+    Reject();
+    return false;
+  }
+  uint16_t seq = p[0] | p[1] << 8;
+  if (seq != nextSeq)
+  {
+    // the expander is at the start of nextSeq, only that one can go on
+    stats.outOfSequence++;
+    Ack(ALBUM_ART_STATUS_SEND);
+    return false;
+  }
+  if (bytes + length - 2 > size)
+  {
+    Reject(); // more than the begin declared
+    return false;
+  }
+
+  uint32_t startMicros = micros();
+  Expand(p + 2, length - 2);
+  decodeMicros += micros() - startMicros;
+  bytes += length - 2;
+  nextSeq++;
+
+  if (pixelIndex < ALBUM_ART_PIXELS && bytes < size)
+  {
+    Ack(ALBUM_ART_STATUS_SEND);
+    return false;
+  }
+  // the last pixel and the declared size have to be reached together
+  if (pixelIndex < ALBUM_ART_PIXELS || bytes != size)
+  {
+    Reject();
+    return false;
+  }
+  return Finish();
+}
+
+// ends any transfer, the host has to begin again
+void AlbumArt::Reject()
+{
+  isReceiving = false;
+  stats.rejected++;
+  Ack(ALBUM_ART_STATUS_REJECTED);
+}
+
+// resumable at any byte, a run or literal may be split across chunks
+void AlbumArt::Expand(const uint8_t *data, uint16_t length)
+{
+  for (uint16_t i = 0; i < length; i++)
+  {
+    uint8_t b = data[i];
+    switch (state)
+    {
+    case ExpandHeader:
+      remaining = (b & 0x7F) + 1;
+      state = b & 0x80 ? ExpandRunLow : ExpandLiteralLow;
+      break;
+    case ExpandRunLow:
+      low = b;
+      state = ExpandRunHigh;
+      break;
+    case ExpandRunHigh:
+      while (remaining > 0)
+      {
+        Put(low | b << 8);
+        remaining--;
+      }
+      state = ExpandHeader;
+      break;
+    case ExpandLiteralLow:
+      low = b;
+      state = ExpandLiteralHigh;
+      break;
+    case ExpandLiteralHigh:
+      Put(low | b << 8);
+      state = --remaining > 0 ? ExpandLiteralLow : ExpandHeader;
+      break;
+    }
+  }
+}
+
+// sprites hold pixels in SPI byte order, pixels past the last one are ignored
+void AlbumArt::Put(uint16_t color)
+{
+  if (pixelIndex >= ALBUM_ART_PIXELS)
+  {
+    return;
+  }
+  ((uint16_t *)sprite.getPointer())[pixelIndex++] = color >> 8 | color << 8;
+}
+
+bool AlbumArt::Finish()
+{
+  isReceiving = false;
+  isShown = true;
+
+  if (cache != nullptr)
+  {
+    // least recently used slot, an empty one first
+    uint8_t slot = 0;
+    for (uint8_t i = 1; i < ALBUM_ART_CACHE_SLOTS; i++)
+    {
+      if (cacheUsed[i] < cacheUsed[slot])
+        slot = i;
+    }
+    memcpy(cache + slot * ALBUM_ART_PIXELS, sprite.getPointer(), ALBUM_ART_PIXELS * sizeof(uint16_t));
+    cacheHashes[slot] = hash;
+    cacheUsed[slot] = ++useCount;
+  }
+
+  stats.images++;
+  stats.bytesTotal += bytes;
+  stats.lastBytes = bytes;
+  stats.lastTransferMs = millis() - startMillis;
+  stats.lastDecodeMicros = decodeMicros;
+  Ack(ALBUM_ART_STATUS_DONE);
+  logOut->printf("[ART] %08x %ux%u, %u B in %u ms (%.1f KB/s), expanded in %u us\n", hash, ALBUM_ART_SIZE, ALBUM_ART_SIZE,
+              bytes, stats.lastTransferMs, stats.lastTransferMs ? bytes / 1.024 / stats.lastTransferMs : 0.0,
+              decodeMicros);
+  return true;
+}
+
+int8_t AlbumArt::Find(uint32_t trackHash)
+{
+  if (cache == nullptr)
+  {
+    return -1;
+  }
+  for (uint8_t i = 0; i < ALBUM_ART_CACHE_SLOTS; i++)
+  {
+    if (cacheUsed[i] != 0 && cacheHashes[i] == trackHash)
+      return i;
+  }
+  return -1;
+}
+
+// [status][track hash u32][next seq u16]
+void AlbumArt::Ack(uint8_t status)
+{
+  uint8_t payload[7] = {status, (uint8_t)hash, (uint8_t)(hash >> 8), (uint8_t)(hash >> 16), (uint8_t)(hash >> 24),
+                        (uint8_t)nextSeq, (uint8_t)(nextSeq >> 8)};
+  PlayerLinkWrite(*out, screen, field, LinkBytes, payload, sizeof(payload));
+}
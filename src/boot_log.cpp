@@ -0,0 +1,65 @@
+#include "boot_log.h"
+
+void BootLog::Begin(Print &output, const char *const *names, uint8_t count)
+{
+  out = &output;
+  phaseNames = names;
+  phaseCount = min<uint8_t>(count, BOOT_LOG_MAX_PHASES);
+  for (uint8_t i = 0; i < BOOT_LOG_MAX_PHASES; i++)
+  {
+    atMillis[i] = BOOT_LOG_PENDING;
+    budgetMs[i] = BOOT_LOG_PENDING;
+  }
+}
+
+void BootLog::SetBudget(uint8_t phase, uint32_t ms)
+{
+  if (phase < phaseCount)
+  {
+    budgetMs[phase] = ms;
+  }
+}
+
+void BootLog::Mark(uint8_t phase)
+{
+  if (phase >= phaseCount || atMillis[phase] != BOOT_LOG_PENDING)
+  {
+    return;
+  }
+  atMillis[phase] = millis();
+
+  if (atMillis[phase] > budgetMs[phase])
+  {
+    overBudget++;
+    out->printf("[BOOT] %s at %u ms, over the %u ms budget\n", phaseNames[phase], atMillis[phase], budgetMs[phase]);
+  }
+  else
+  {
+    out->printf("[BOOT] %s at %u ms\n", phaseNames[phase], atMillis[phase]);
+  }
+}
+
+bool BootLog::IsMarked(uint8_t phase)
+{
+  return phase < phaseCount && atMillis[phase] != BOOT_LOG_PENDING;
+}
+
+uint32_t BootLog::At(uint8_t phase)
+{
+  return phase < phaseCount ? atMillis[phase] : BOOT_LOG_PENDING;
+}
+
+const char *BootLog::Name(uint8_t phase)
+{
+  return phase < phaseCount ? phaseNames[phase] : "";
+}
+
+uint8_t BootLog::PhaseCount()
+{
+  return phaseCount;
+}
+
+uint8_t BootLog::OverBudget()
+{
+  return overBudget;
+}
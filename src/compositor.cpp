@@ -0,0 +1,311 @@
+#include "compositor.h"
+
+static int32_t RectArea(const DirtyRect &rect)
+{
+  return (int32_t)rect.w * rect.h;
+}
+
+// touching rects count as overlapping, so adjacent text rows are pushed in one go
+static bool RectsOverlap(const DirtyRect &a, const DirtyRect &b)
+{
+  return a.x <= b.x + b.w && b.x <= a.x + a.w &&
+         a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+static DirtyRect RectUnion(const DirtyRect &a, const DirtyRect &b)
+{
+  int16_t x0 = min(a.x, b.x);
+  int16_t y0 = min(a.y, b.y);
+  int16_t x1 = max(a.x + a.w, b.x + b.w);
+  int16_t y1 = max(a.y + a.h, b.y + b.h);
+  return {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+}
+
+Compositor::Compositor(TFT_eSPI &display, TFT_eSprite &canvas)
+    : tft(display), canvas(canvas)
+{
+}
+
+bool Compositor::Begin(uint16_t fillColor)
+{
+  width = tft.width();
+  height = tft.height();
+
+  canvas.setColorDepth(16);
+  if (canvas.createSprite(width, height) == nullptr)
+  {
+    return false;
+  }
+
+  Clear(fillColor);
+  secStartMillis = millis();
+
+#ifndef COMPOSITOR_DMA_DISABLE
+  // without DMA or its buffers Flush() falls back to blocking pushes
+  if (tft.initDMA())
+  {
+    dmaBuffers[0] = (uint16_t *)malloc(COMPOSITOR_DMA_BUFFER_PIXELS * sizeof(uint16_t));
+    dmaBuffers[1] = (uint16_t *)malloc(COMPOSITOR_DMA_BUFFER_PIXELS * sizeof(uint16_t));
+    if (dmaBuffers[0] == nullptr || dmaBuffers[1] == nullptr)
+    {
+      free(dmaBuffers[0]);
+      free(dmaBuffers[1]);
+      dmaBuffers[0] = dmaBuffers[1] = nullptr;
+      tft.deInitDMA();
+    }
+  }
+#endif
+  return true;
+}
+
+void Compositor::MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h)
+{
+  DirtyRect rect = {(int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h};
+  if (ClipRect(rect))
+  {
+    AddRect(rect);
+  }
+}
+
+void Compositor::MarkAllDirty()
+{
+  rects[0] = {0, 0, width, height};
+  rectCount = 1;
+}
+
+void Compositor::Clear(uint16_t fillColor)
+{
+  canvas.fillSprite(fillColor);
+  MarkAllDirty();
+}
+
+void Compositor::Blit(TFT_eSprite &src, int32_t x, int32_t y)
+{
+  DirtyRect rect = {(int16_t)x, (int16_t)y, (int16_t)src.width(), (int16_t)src.height()};
+  if (!ClipRect(rect))
+  {
+    return;
+  }
+
+  // both buffers hold pixels in the same byte order, so rows copy as is
+  const uint16_t *srcPixels = (const uint16_t *)src.getPointer();
+  uint16_t *dstPixels = (uint16_t *)canvas.getPointer();
+  if (srcPixels == nullptr || dstPixels == nullptr)
+  {
+    return;
+  }
+  for (int16_t row = 0; row < rect.h; row++)
+  {
+    memcpy(dstPixels + (rect.y + row) * width + rect.x,
+           srcPixels + (rect.y - y + row) * src.width() + (rect.x - x),
+           rect.w * sizeof(uint16_t));
+  }
+  AddRect(rect);
+}
+
+void Compositor::BlitWrapped(TFT_eSprite &src, int32_t srcX, int32_t srcY, int32_t x, int32_t y, int32_t w, int32_t h, int32_t wrapWidth)
+{
+  h = min<int32_t>(h, src.height() - srcY);
+  DirtyRect rect = {(int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h};
+  int32_t srcWidth = src.width();
+  wrapWidth = wrapWidth > 0 ? min(wrapWidth, srcWidth) : srcWidth;
+  if (srcWidth <= 0 || srcY < 0 || h <= 0 || !ClipRect(rect))
+  {
+    return;
+  }
+
+  const uint16_t *srcPixels = (const uint16_t *)src.getPointer();
+  uint16_t *dstPixels = (uint16_t *)canvas.getPointer();
+  if (srcPixels == nullptr || dstPixels == nullptr)
+  {
+    return;
+  }
+  for (int16_t row = 0; row < rect.h; row++)
+  {
+    const uint16_t *srcRow = srcPixels + (srcY + rect.y - y + row) * srcWidth;
+    uint16_t *dstRow = dstPixels + (rect.y + row) * width + rect.x;
+    int32_t column = (srcX + rect.x - x) % wrapWidth;
+    int32_t remaining = rect.w;
+    // the tail of the source, then on from its head
+    while (remaining > 0)
+    {
+      int32_t run = min(remaining, wrapWidth - column);
+      memcpy(dstRow, srcRow + column, run * sizeof(uint16_t));
+      dstRow += run;
+      remaining -= run;
+      column = 0;
+    }
+  }
+  AddRect(rect);
+}
+
+void Compositor::Flush()
+{
+  UpdateRate();
+  if (rectCount == 0)
+  {
+    return;
+  }
+
+  if (dmaBuffers[0] != nullptr)
+  {
+    FlushDma();
+  }
+  else
+  {
+    tft.startWrite();
+    for (uint8_t i = 0; i < rectCount; i++)
+    {
+      const DirtyRect &rect = rects[i];
+      canvas.pushSprite(rect.x, rect.y, rect.x, rect.y, rect.w, rect.h);
+    }
+    tft.endWrite();
+  }
+
+  for (uint8_t i = 0; i < rectCount; i++)
+  {
+    uint32_t bytes = RectArea(rects[i]) * sizeof(uint16_t);
+    stats.bytesPushedTotal += bytes;
+    bytesThisSec += bytes;
+  }
+  stats.rectsPushedTotal += rectCount;
+  stats.flushCount++;
+  framesThisSec++;
+  rectCount = 0;
+}
+
+void Compositor::Sync()
+{
+  if (!isWriting)
+  {
+    return;
+  }
+  WaitDma();
+  tft.endWrite();
+  isWriting = false;
+}
+
+// rows of the canvas region go to the free staging buffer, the other one is on the wire meanwhile
+void Compositor::FlushDma()
+{
+  if (!isWriting)
+  {
+    tft.startWrite();
+    isWriting = true;
+  }
+
+  const uint16_t *canvasPixels = (const uint16_t *)canvas.getPointer();
+  for (uint8_t i = 0; i < rectCount; i++)
+  {
+    const DirtyRect &rect = rects[i];
+    int16_t bandRows = max(1, COMPOSITOR_DMA_BUFFER_PIXELS / rect.w);
+    for (int16_t row = 0; row < rect.h; row += bandRows)
+    {
+      int16_t rows = min<int16_t>(bandRows, rect.h - row);
+      uint16_t *buffer = dmaBuffers[dmaNext];
+      for (int16_t line = 0; line < rows; line++)
+      {
+        memcpy(buffer + line * rect.w, canvasPixels + (rect.y + row + line) * width + rect.x, rect.w * sizeof(uint16_t));
+      }
+
+      // swap point: the band before this one has to be out before the next is queued
+      WaitDma();
+      tft.pushImageDMA(rect.x, rect.y + row, rect.w, rows, buffer);
+      dmaNext ^= 1;
+    }
+  }
+}
+
+void Compositor::WaitDma()
+{
+  if (!tft.dmaBusy())
+  {
+    return;
+  }
+  unsigned long startMicros = micros();
+  tft.dmaWait();
+  uint32_t waited = micros() - startMicros;
+  stats.dmaWaitMicrosTotal += waited;
+  dmaWaitMicrosThisSec += waited;
+}
+
+const CompositorStats &Compositor::Stats()
+{
+  UpdateRate();
+  return stats;
+}
+
+bool Compositor::ClipRect(DirtyRect &rect)
+{
+  int32_t x0 = max<int32_t>(rect.x, 0);
+  int32_t y0 = max<int32_t>(rect.y, 0);
+  int32_t x1 = min<int32_t>(rect.x + rect.w, width);
+  int32_t y1 = min<int32_t>(rect.y + rect.h, height);
+  if (x1 <= x0 || y1 <= y0)
+  {
+    return false;
+  }
+
+  rect = {(int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+  return true;
+}
+
+void Compositor::AddRect(DirtyRect rect)
+{
+  // absorb every rect the new one overlaps, rescanning since the union grows
+  bool merged = true;
+  while (merged)
+  {
+    merged = false;
+    for (uint8_t i = 0; i < rectCount; i++)
+    {
+      if (RectsOverlap(rects[i], rect))
+      {
+        rect = RectUnion(rects[i], rect);
+        rects[i] = rects[--rectCount];
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  if (rectCount < COMPOSITOR_MAX_DIRTY_RECTS)
+  {
+    rects[rectCount++] = rect;
+    return;
+  }
+
+  // list is full, merge into the rect that grows the least
+  uint8_t bestIndex = 0;
+  int32_t bestGrowth = INT32_MAX;
+  for (uint8_t i = 0; i < rectCount; i++)
+  {
+    int32_t growth = RectArea(RectUnion(rects[i], rect)) - RectArea(rects[i]);
+    if (growth < bestGrowth)
+    {
+      bestGrowth = growth;
+      bestIndex = i;
+    }
+  }
+  rect = RectUnion(rects[bestIndex], rect);
+  rects[bestIndex] = rects[--rectCount];
+  AddRect(rect);
+}
+
+void Compositor::UpdateRate()
+{
+  unsigned long now = millis();
+  unsigned long elapsed = now - secStartMillis;
+  if (elapsed < 1000)
+  {
+    return;
+  }
+
+  stats.bytesPushedPerSec = (uint64_t)bytesThisSec * 1000 / elapsed;
+  stats.framesPerSec = framesThisSec * 1000.0F / elapsed;
+  stats.dmaWaitPercent = dmaWaitMicrosThisSec / (elapsed * 10.0F);
+  bytesThisSec = 0;
+  framesThisSec = 0;
+  dmaWaitMicrosThisSec = 0;
+  secStartMillis = now;
+}
@@ -0,0 +1,162 @@
+#include "digit_atlas.h"
+
+DigitAtlas::DigitAtlas(TFT_eSPI *display)
+    : display(display)
+{
+}
+
+bool DigitAtlas::Begin(uint8_t atlasFont, uint16_t lit, uint16_t ghost, uint16_t bg)
+{
+  font = atlasFont;
+  litColor = lit;
+  ghostColor = ghost;
+  bgColor = bg;
+  litPixel = lit >> 8 | lit << 8;
+  ghostPixel = ghost >> 8 | ghost << 8;
+  bgPixel = bg >> 8 | bg << 8;
+  digitWidth = display->textWidth("8", font);
+  colonWidth = display->textWidth(":", font);
+  height = display->fontHeight(font);
+
+  free(masks);
+  free(linePixels);
+  masks = (uint8_t *)malloc((10 * MaskStride(0) + MaskStride(10)) * height);
+  linePixels = (uint16_t *)malloc(max(digitWidth, colonWidth) * sizeof(uint16_t));
+  if (masks == nullptr || linePixels == nullptr)
+  {
+    free(masks);
+    free(linePixels);
+    masks = nullptr;
+    linePixels = nullptr;
+    return false;
+  }
+
+  // the scratch sprite rasterizes one character at a time, then goes away
+  TFT_eSprite scratch(display);
+  scratch.setColorDepth(16);
+  if (scratch.createSprite(max(digitWidth, colonWidth), height) == nullptr)
+  {
+    free(masks);
+    free(linePixels);
+    masks = nullptr;
+    linePixels = nullptr;
+    return false;
+  }
+  for (uint8_t mask = 0; mask <= 10; mask++)
+  {
+    RenderMask(scratch, mask);
+  }
+  scratch.deleteSprite();
+  return true;
+}
+
+int16_t DigitAtlas::DrawDigit(TFT_eSprite &dst, uint8_t digit, int32_t x, int32_t y)
+{
+  return DrawCell(dst, digit % 10, x, y);
+}
+
+int16_t DigitAtlas::DrawColon(TFT_eSprite &dst, bool isLit, int32_t x, int32_t y)
+{
+  return DrawCell(dst, isLit ? DIGIT_ATLAS_COLON_LIT : DIGIT_ATLAS_COLON_GHOST, x, y);
+}
+
+int16_t DigitAtlas::DigitWidth()
+{
+  return digitWidth;
+}
+
+int16_t DigitAtlas::ColonWidth()
+{
+  return colonWidth;
+}
+
+int16_t DigitAtlas::Height()
+{
+  return height;
+}
+
+const DigitAtlasStats &DigitAtlas::Stats()
+{
+  return stats;
+}
+
+int16_t DigitAtlas::DrawCell(TFT_eSprite &dst, uint8_t cell, int32_t x, int32_t y)
+{
+  if (masks == nullptr)
+  {
+    // no atlas, rasterize like the ghost-then-lit drawing it replaces
+    dst.setTextColor(ghostColor, bgColor);
+    dst.drawChar(cell < 10 ? '8' : ':', x, y, font);
+    if (cell != DIGIT_ATLAS_COLON_GHOST)
+    {
+      dst.setTextColor(litColor);
+      dst.drawChar(CellChar(cell), x, y, font);
+    }
+    stats.fallbackDraws++;
+    return CellWidth(cell);
+  }
+
+  // a digit over the ghosted 8, the colon over itself
+  uint8_t index = cell < 10 ? cell : 10;
+  const uint8_t *litMask = Mask(index);
+  const uint8_t *ghostMask = Mask(cell < 10 ? 8 : 10);
+  uint16_t fgPixel = cell == DIGIT_ATLAS_COLON_GHOST ? ghostPixel : litPixel;
+  uint8_t stride = MaskStride(index);
+  int16_t width = CellWidth(cell);
+  for (int16_t row = 0; row < height; row++)
+  {
+    for (int16_t col = 0; col < width; col++)
+    {
+      uint16_t byte = row * stride + col / 8;
+      uint8_t bit = 0x80 >> (col & 7);
+      linePixels[col] = litMask[byte] & bit ? fgPixel : ghostMask[byte] & bit ? ghostPixel : bgPixel;
+    }
+    dst.pushImage(x, y + row, width, 1, linePixels);
+  }
+  stats.blits++;
+  return width;
+}
+
+// set bits where the character differs from the background it was drawn on
+void DigitAtlas::RenderMask(TFT_eSprite &scratch, uint8_t mask)
+{
+  scratch.fillSprite(bgColor);
+  scratch.setTextColor(litColor, bgColor);
+  scratch.drawChar(CellChar(mask), 0, 0, font);
+
+  const uint16_t *source = (const uint16_t *)scratch.getPointer();
+  uint8_t *target = Mask(mask);
+  uint8_t stride = MaskStride(mask);
+  int16_t width = CellWidth(mask);
+  memset(target, 0, stride * height);
+  for (int16_t row = 0; row < height; row++)
+  {
+    for (int16_t col = 0; col < width; col++)
+    {
+      if (source[row * scratch.width() + col] != bgPixel)
+      {
+        target[row * stride + col / 8] |= 0x80 >> (col & 7);
+      }
+    }
+  }
+}
+
+char DigitAtlas::CellChar(uint8_t cell)
+{
+  return cell < 10 ? '0' + cell : ':';
+}
+
+int16_t DigitAtlas::CellWidth(uint8_t cell)
+{
+  return cell < 10 ? digitWidth : colonWidth;
+}
+
+uint8_t DigitAtlas::MaskStride(uint8_t mask)
+{
+  return (CellWidth(mask) + 7) / 8;
+}
+
+uint8_t *DigitAtlas::Mask(uint8_t mask)
+{
+  return masks + (mask < 10 ? mask : 10) * MaskStride(0) * height;
+}
@@ -0,0 +1,300 @@
+#include "glyph_cache.h"
+
+#define GLYPH_NONE 0xFF
+
+static uint16_t SwapBytes(uint16_t color)
+{
+  return color << 8 | color >> 8;
+}
+
+// decode one BMP codepoint, invalid or 4 byte sequences become '?'
+static uint16_t DecodeUtf8(const uint8_t *buf, uint16_t &index, uint16_t len)
+{
+  uint8_t c = buf[index++];
+  if (c < 0x80)
+  {
+    return c;
+  }
+  if ((c & 0xE0) == 0xC0 && index < len)
+  {
+    return (c & 0x1F) << 6 | (buf[index++] & 0x3F);
+  }
+  if ((c & 0xF0) == 0xE0 && index + 1 < len)
+  {
+    uint16_t code = (c & 0x0F) << 12 | (buf[index] & 0x3F) << 6 | (buf[index + 1] & 0x3F);
+    index += 2;
+    return code;
+  }
+  while (index < len && (buf[index] & 0xC0) == 0x80)
+  {
+    index++;
+  }
+  return '?';
+}
+
+GlyphCache::GlyphCache(TFT_eSPI *display)
+    : fontSource(display)
+{
+}
+
+bool GlyphCache::Begin(const uint8_t font[])
+{
+  fontArray = font;
+  fontSource.loadFont(font);
+  if (!fontSource.fontLoaded)
+  {
+    return false;
+  }
+
+  cellHeight = fontSource.gFont.yAdvance;
+  uint8_t maxAdvance = fontSource.gFont.spaceWidth + 1;
+  for (uint16_t i = 0; i < fontSource.gFont.gCount; i++)
+  {
+    maxAdvance = max(maxAdvance, fontSource.gxAdvance[i]);
+  }
+  slotPixels = maxAdvance * cellHeight;
+
+  for (uint8_t i = 0; i < GLYPH_CACHE_BUCKETS; i++)
+  {
+    buckets[i] = GLYPH_NONE;
+  }
+  lruHead = lruTail = GLYPH_NONE;
+  usedSlots = 0;
+
+#ifdef GLYPH_CACHE_DISABLE
+  return true;
+#else
+  pixels = (uint16_t *)malloc(GLYPH_CACHE_SLOTS * slotPixels * sizeof(uint16_t));
+  return pixels != nullptr;
+#endif
+}
+
+int16_t GlyphCache::DrawString(TFT_eSprite &dst, const char *str, uint16_t length, int32_t x, int32_t y, uint16_t fg, uint16_t bg)
+{
+  unsigned long startMicros = micros();
+  int16_t width;
+
+  if (pixels == nullptr)
+  {
+    // uncached path, same as loading the font around every draw
+    String text;
+    text.concat(str, length);
+    dst.loadFont(fontArray);
+    dst.setTextColor(fg, bg);
+    width = dst.drawString(text, x, y);
+    dst.unloadFont();
+  }
+  else
+  {
+    const uint8_t *buf = (const uint8_t *)str;
+    uint16_t index = 0;
+    int32_t cursorX = x;
+    while (index < length)
+    {
+      uint16_t code = DecodeUtf8(buf, index, length);
+      if (code == '\n' || code == '\r')
+      {
+        continue;
+      }
+      uint8_t slot = Acquire(code, fg, bg);
+      dst.pushImage(cursorX, y, entries[slot].width, cellHeight, pixels + slot * slotPixels);
+      cursorX += entries[slot].width;
+    }
+    width = cursorX - x;
+  }
+
+  stats.strings++;
+  stats.renderMicros += micros() - startMicros;
+  return width;
+}
+
+int16_t GlyphCache::TextWidth(const char *str, uint16_t length)
+{
+  const uint8_t *buf = (const uint8_t *)str;
+  uint16_t index = 0;
+  int16_t width = 0;
+  while (index < length)
+  {
+    uint16_t code = DecodeUtf8(buf, index, length);
+    if (code != '\n' && code != '\r')
+    {
+      width += GlyphAdvance(code);
+    }
+  }
+  return width;
+}
+
+int16_t GlyphCache::LineHeight()
+{
+  return cellHeight;
+}
+
+const GlyphCacheStats &GlyphCache::Stats()
+{
+  return stats;
+}
+
+uint8_t GlyphCache::Acquire(uint16_t code, uint16_t fg, uint16_t bg)
+{
+  uint8_t bucket = Bucket(code, fg, bg);
+  for (uint8_t slot = buckets[bucket]; slot != GLYPH_NONE; slot = entries[slot].hashNext)
+  {
+    GlyphEntry &entry = entries[slot];
+    if (entry.code == code && entry.fg == fg && entry.bg == bg)
+    {
+      stats.hits++;
+      if (slot != lruHead)
+      {
+        LruUnlink(slot);
+        LruPushFront(slot);
+      }
+      return slot;
+    }
+  }
+
+  stats.misses++;
+  uint8_t slot;
+  if (usedSlots < GLYPH_CACHE_SLOTS)
+  {
+    slot = usedSlots++;
+  }
+  else
+  {
+    // reuse least recently drawn glyph
+    slot = lruTail;
+    HashRemove(slot);
+    LruUnlink(slot);
+    stats.evictions++;
+  }
+
+  Render(slot, code, fg, bg);
+  entries[slot].hashNext = buckets[bucket];
+  buckets[bucket] = slot;
+  LruPushFront(slot);
+  return slot;
+}
+
+void GlyphCache::Render(uint8_t slot, uint16_t code, uint16_t fg, uint16_t bg)
+{
+  GlyphEntry &entry = entries[slot];
+  entry.code = code;
+  entry.fg = fg;
+  entry.bg = bg;
+
+  uint16_t gNum;
+  bool found = code >= 0x21 && fontSource.getUnicodeIndex(code, &gNum);
+  if (found)
+    entry.width = fontSource.gxAdvance[gNum];
+  else
+    entry.width = code < 0x21 ? fontSource.gFont.spaceWidth : fontSource.gFont.spaceWidth + 1;
+
+  // cells are stored in sprite byte order so pushImage is a plain copy
+  uint16_t *cell = pixels + slot * slotPixels;
+  uint16_t bgPixel = SwapBytes(bg);
+  for (uint16_t i = 0; i < entry.width * cellHeight; i++)
+  {
+    cell[i] = bgPixel;
+  }
+
+  if (!found)
+  {
+    if (code >= 0x21)
+    {
+      // missing glyph, draw a box like TFT_eSPI does
+      int16_t top = fontSource.gFont.maxAscent - fontSource.gFont.ascent;
+      for (int16_t cy = top; cy < top + fontSource.gFont.ascent && cy < cellHeight; cy++)
+      {
+        for (int16_t cx = 0; cx < entry.width - 1; cx++)
+        {
+          if (cy == top || cy == top + fontSource.gFont.ascent - 1 || cx == 0 || cx == entry.width - 2)
+            cell[cy * entry.width + cx] = SwapBytes(fg);
+        }
+      }
+    }
+    return;
+  }
+
+  // glyph pixels outside the advance cell are clipped
+  const uint8_t *bitmap = fontArray + fontSource.gBitmap[gNum];
+  uint8_t glyphWidth = fontSource.gWidth[gNum];
+  uint8_t glyphHeight = fontSource.gHeight[gNum];
+  int16_t top = fontSource.gFont.maxAscent - fontSource.gdY[gNum];
+  int16_t left = fontSource.gdX[gNum];
+  for (uint8_t row = 0; row < glyphHeight; row++)
+  {
+    int16_t cy = top + row;
+    if (cy < 0 || cy >= cellHeight)
+      continue;
+    for (uint8_t col = 0; col < glyphWidth; col++)
+    {
+      int16_t cx = left + col;
+      if (cx < 0 || cx >= entry.width)
+        continue;
+      uint8_t alpha = pgm_read_byte(bitmap + row * glyphWidth + col);
+      if (alpha == 0)
+        continue;
+      uint16_t color = alpha == 255 ? fg : fontSource.alphaBlend(alpha, fg, bg);
+      cell[cy * entry.width + cx] = SwapBytes(color);
+    }
+  }
+}
+
+uint8_t GlyphCache::GlyphAdvance(uint16_t code)
+{
+  uint16_t gNum;
+  if (code < 0x21)
+  {
+    return fontSource.gFont.spaceWidth;
+  }
+  if (!fontSource.getUnicodeIndex(code, &gNum))
+  {
+    return fontSource.gFont.spaceWidth + 1;
+  }
+  return fontSource.gxAdvance[gNum];
+}
+
+void GlyphCache::LruUnlink(uint8_t slot)
+{
+  GlyphEntry &entry = entries[slot];
+  if (entry.lruPrev != GLYPH_NONE)
+    entries[entry.lruPrev].lruNext = entry.lruNext;
+  else
+    lruHead = entry.lruNext;
+  if (entry.lruNext != GLYPH_NONE)
+    entries[entry.lruNext].lruPrev = entry.lruPrev;
+  else
+    lruTail = entry.lruPrev;
+}
+
+void GlyphCache::LruPushFront(uint8_t slot)
+{
+  GlyphEntry &entry = entries[slot];
+  entry.lruPrev = GLYPH_NONE;
+  entry.lruNext = lruHead;
+  if (lruHead != GLYPH_NONE)
+    entries[lruHead].lruPrev = slot;
+  lruHead = slot;
+  if (lruTail == GLYPH_NONE)
+    lruTail = slot;
+}
+
+void GlyphCache::HashRemove(uint8_t slot)
+{
+  GlyphEntry &entry = entries[slot];
+  uint8_t *link = &buckets[Bucket(entry.code, entry.fg, entry.bg)];
+  while (*link != GLYPH_NONE)
+  {
+    if (*link == slot)
+    {
+      *link = entry.hashNext;
+      return;
+    }
+    link = &entries[*link].hashNext;
+  }
+}
+
+uint8_t GlyphCache::Bucket(uint16_t code, uint16_t fg, uint16_t bg)
+{
+  uint32_t hash = (code * 2654435761UL) ^ (fg * 40503UL) ^ bg;
+  return (hash ^ hash >> 16) & (GLYPH_CACHE_BUCKETS - 1);
+}
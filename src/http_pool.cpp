@@ -0,0 +1,278 @@
+#include "http_pool.h"
+#include <esp_timer.h>
+
+static const char *headerKeys[] = {"Transfer-Encoding"};
+
+void HttpBodyStream::Begin(Stream *source, int32_t size, bool isChunked)
+{
+  this->source = source;
+  this->isChunked = isChunked;
+  remaining = isChunked ? 0 : size;
+  isChunkStarted = false;
+  isDone = source == nullptr;
+  isReusable = source != nullptr && (isChunked || size >= 0); // otherwise the body ends with the connection
+}
+
+void HttpBodyStream::Drain()
+{
+  while (isReusable && read() >= 0)
+  {
+  }
+}
+
+bool HttpBodyStream::IsClean()
+{
+  return isReusable && isDone;
+}
+
+int HttpBodyStream::available()
+{
+  if (isDone)
+  {
+    return 0;
+  }
+  int count = source->available();
+  return remaining < 0 ? count : min<int32_t>(count, remaining);
+}
+
+int HttpBodyStream::read()
+{
+  if (!Ready())
+  {
+    return -1;
+  }
+  uint8_t c;
+  if (source->readBytes(&c, 1) != 1)
+  {
+    // timed out or closed before the end of the body
+    isDone = true;
+    isReusable = false;
+    return -1;
+  }
+  if (remaining > 0)
+  {
+    remaining--;
+  }
+  return c;
+}
+
+int HttpBodyStream::peek()
+{
+  return Ready() ? source->peek() : -1;
+}
+
+bool HttpBodyStream::Ready()
+{
+  if (isDone)
+  {
+    return false;
+  }
+  if (remaining == 0 && !(isChunked && NextChunk()))
+  {
+    isDone = true;
+    return false;
+  }
+  return true;
+}
+
+// "<hex size>[;extension]\r\n" before every chunk and "\r\n" after its data,
+// a zero size chunk ends the body and is followed by optional trailer lines
+bool HttpBodyStream::NextChunk()
+{
+  char line[24];
+  if (isChunkStarted && source->readBytesUntil('\n', line, sizeof(line)) != 1)
+  {
+    isReusable = false;
+    return false;
+  }
+  isChunkStarted = true;
+
+  size_t length = source->readBytesUntil('\n', line, sizeof(line) - 1);
+  line[length] = '\0';
+  if (length == sizeof(line) - 1)
+  {
+    source->find((char *)"\n"); // long chunk extension
+  }
+  char *end;
+  long size = strtol(line, &end, 16);
+  if (end == line || size < 0)
+  {
+    isReusable = false;
+    return false;
+  }
+
+  if (size == 0)
+  {
+    while ((length = source->readBytesUntil('\n', line, sizeof(line))) > 1)
+    {
+    }
+    if (length != 1)
+    {
+      isReusable = false; // timed out before the empty line
+    }
+    return false;
+  }
+
+  remaining = size;
+  return true;
+}
+
+int HttpPool::Get(const String &url, uint32_t idleMs)
+{
+  CloseIdle();
+
+  // the scheme stays in the key, an http and an https host never share a socket
+  int hostStart = url.indexOf("://");
+  hostStart = hostStart < 0 ? 0 : hostStart + 3;
+  int hostEnd = url.indexOf('/', hostStart);
+  current = Acquire(url.substring(0, hostEnd < 0 ? url.length() : hostEnd));
+  HostSlot &slot = slots[current];
+  slot.idleMs = idleMs;
+
+  startMicros = esp_timer_get_time();
+  bool wasConnected = slot.client->connected();
+  slot.http.begin(*slot.client, url);
+  currentCode = slot.http.GET();
+  if (currentCode < 0 && wasConnected)
+  {
+    // server dropped the idle socket, retry once on a new connection
+    slot.http.end();
+    slot.client->stop();
+    wasConnected = false;
+    slot.http.begin(*slot.client, url);
+    currentCode = slot.http.GET();
+  }
+  if (!wasConnected)
+  {
+    slot.stats.handshakes++;
+  }
+
+  if (currentCode > 0)
+    body.Begin(slot.http.getStreamPtr(), slot.http.getSize(), slot.http.header("Transfer-Encoding").equalsIgnoreCase("chunked"));
+  else
+    body.Begin(nullptr, 0, false);
+  return currentCode;
+}
+
+Stream &HttpPool::Body()
+{
+  return body;
+}
+
+void HttpPool::End()
+{
+  HostSlot &slot = slots[current];
+  body.Drain();
+  if (!body.IsClean())
+  {
+    slot.client->stop(); // position in the stream is unknown, never reuse it
+  }
+  slot.http.end(); // keeps the socket open when the server allows it
+  slot.lastUsedMillis = millis();
+  HttpRecordRequest(slot.stats, (esp_timer_get_time() - startMicros) / 1000, currentCode == HTTP_CODE_OK);
+}
+
+uint8_t HttpPool::HostCount()
+{
+  return slotCount;
+}
+
+const char *HttpPool::HostName(uint8_t host)
+{
+  return slots[host].host.c_str();
+}
+
+const HttpHostStats &HttpPool::Stats(uint8_t host)
+{
+  return slots[host].stats;
+}
+
+uint8_t HttpPool::Acquire(const String &host)
+{
+  for (uint8_t i = 0; i < slotCount; i++)
+  {
+    if (slots[i].host == host)
+      return i;
+  }
+
+  uint8_t index;
+  if (slotCount < HTTP_POOL_HOSTS)
+  {
+    index = slotCount++;
+  }
+  else
+  {
+    // hand the least recently used host's slot over
+    unsigned long now = millis();
+    index = 0;
+    for (uint8_t i = 1; i < slotCount; i++)
+    {
+      if (now - slots[i].lastUsedMillis > now - slots[index].lastUsedMillis)
+        index = i;
+    }
+    slots[index].client->stop();
+  }
+
+  HostSlot &slot = slots[index];
+  slot.host = host;
+  slot.stats = {};
+  slot.lastUsedMillis = millis();
+  slot.idleMs = HTTP_POOL_IDLE_MS;
+  slot.client = host.startsWith("https://") ? &slot.secureClient : &slot.plainClient;
+  slot.secureClient.setInsecure(); // same as HTTPClient::begin(url) without a CA cert
+  slot.http.setReuse(true);
+  slot.http.collectHeaders(headerKeys, 1);
+  return index;
+}
+
+void HttpPool::CloseIdle()
+{
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < slotCount; i++)
+  {
+    if (now - slots[i].lastUsedMillis > slots[i].idleMs)
+    {
+      slots[i].client->stop();
+    }
+  }
+}
+
+void HttpRecordRequest(HttpHostStats &stats, uint32_t latencyMs, bool isOk)
+{
+  stats.requests++;
+  if (!isOk)
+  {
+    stats.failures++;
+  }
+  stats.maxLatencyMs = max(stats.maxLatencyMs, latencyMs);
+
+  uint8_t bucket = 0;
+  while (bucket < HTTP_LATENCY_BUCKETS - 1 && latencyMs > (16UL << bucket))
+  {
+    bucket++;
+  }
+  stats.latencyBuckets[bucket]++;
+}
+
+uint32_t HttpLatencyPercentile(const HttpHostStats &stats, uint8_t percent)
+{
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < HTTP_LATENCY_BUCKETS; i++)
+  {
+    total += stats.latencyBuckets[i];
+  }
+  if (total == 0)
+  {
+    return 0;
+  }
+
+  uint32_t rank = (total * percent + 99) / 100;
+  uint32_t count = 0;
+  for (uint8_t i = 0; i < HTTP_LATENCY_BUCKETS - 1; i++)
+  {
+    count += stats.latencyBuckets[i];
+    if (count >= rank)
+      return min<uint32_t>(16UL << i, stats.maxLatencyMs);
+  }
+  return stats.maxLatencyMs;
+}
@@ -0,0 +1,126 @@
+#include "http_scheduler.h"
+
+void HttpScheduler::Submit(uint8_t type, uint8_t index, uint8_t priority)
+{
+  uint32_t now = millis();
+  portENTER_CRITICAL(&lock);
+  stats.submitted++;
+
+  // already pending, or covered by a pending job of the whole type
+  for (uint8_t i = 0; i < jobCount; i++)
+  {
+    HttpJob &pending = jobs[i];
+    if (pending.type == type && (pending.index == index || pending.index == HTTP_JOB_ALL))
+    {
+      pending.priority = min(pending.priority, priority);
+      stats.coalesced++;
+      portEXIT_CRITICAL(&lock);
+      return;
+    }
+  }
+
+  // a job of the whole type makes the pending single ones redundant
+  if (index == HTTP_JOB_ALL)
+  {
+    for (uint8_t i = jobCount; i-- > 0;)
+    {
+      if (jobs[i].type == type)
+      {
+        priority = min(priority, jobs[i].priority);
+        RemoveAt(i);
+        stats.coalesced++;
+      }
+    }
+  }
+
+  if (jobCount == HTTP_SCHEDULER_SLOTS)
+  {
+    // the newest of the lowest priority jobs goes, which may be this one
+    uint8_t worst = 0;
+    for (uint8_t i = 1; i < jobCount; i++)
+    {
+      if (jobs[i].priority >= jobs[worst].priority)
+        worst = i;
+    }
+    stats.droppedFull++;
+    if (jobs[worst].priority <= priority)
+    {
+      portEXIT_CRITICAL(&lock);
+      return;
+    }
+    RemoveAt(worst);
+  }
+
+  jobs[jobCount++] = {type, index, priority, now};
+  TaskHandle_t task = consumer;
+  portEXIT_CRITICAL(&lock);
+
+  if (task != nullptr)
+    xTaskNotifyGive(task);
+}
+
+bool HttpScheduler::Take(HttpJob &job, uint32_t timeoutMs)
+{
+  if (consumer == nullptr)
+  {
+    portENTER_CRITICAL(&lock);
+    consumer = xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&lock);
+  }
+
+  if (PopBest(job))
+    return true;
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+  return PopBest(job);
+}
+
+bool HttpScheduler::PopBest(HttpJob &job)
+{
+  uint32_t now = millis();
+  portENTER_CRITICAL(&lock);
+  if (jobCount == 0)
+  {
+    portEXIT_CRITICAL(&lock);
+    return false;
+  }
+
+  // jobs are kept in submit order, so the first of the best priority is the oldest
+  uint8_t best = 0;
+  for (uint8_t i = 1; i < jobCount; i++)
+  {
+    if (jobs[i].priority < jobs[best].priority)
+      best = i;
+  }
+  job = jobs[best];
+  RemoveAt(best);
+
+  uint32_t queuedMs = now - job.queuedMillis;
+  stats.served++;
+  stats.queuedMsTotal += queuedMs;
+  stats.queuedMsMax = max(stats.queuedMsMax, queuedMs);
+  portEXIT_CRITICAL(&lock);
+  return true;
+}
+
+// keeps submit order, caller holds the lock
+void HttpScheduler::RemoveAt(uint8_t slot)
+{
+  jobCount--;
+  memmove(jobs + slot, jobs + slot + 1, (jobCount - slot) * sizeof(jobs[0]));
+}
+
+uint8_t HttpScheduler::Pending()
+{
+  portENTER_CRITICAL(&lock);
+  uint8_t count = jobCount;
+  portEXIT_CRITICAL(&lock);
+  return count;
+}
+
+HttpSchedulerStats HttpScheduler::Stats()
+{
+  portENTER_CRITICAL(&lock);
+  HttpSchedulerStats copy = stats;
+  portEXIT_CRITICAL(&lock);
+  return copy;
+}
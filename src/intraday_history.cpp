@@ -0,0 +1,65 @@
+#include "intraday_history.h"
+
+void IntradayHistory::Reset()
+{
+  memset(heads, 0, sizeof(heads));
+  memset(counts, 0, sizeof(counts));
+  // appended keeps counting, a drawer sees the jump and redraws
+}
+
+void IntradayHistory::Record(uint8_t index, uint16_t minute, float price, float previousClose)
+{
+  if (index >= WATCHLIST_MAX_SYMBOLS || minute >= INTRADAY_SESSION_MINUTES || previousClose == 0)
+  {
+    return;
+  }
+
+  int32_t delta = lroundf((price - previousClose) / previousClose * INTRADAY_SCALE);
+  int16_t tick = constrain(delta, (int32_t)INT16_MIN, (int32_t)INT16_MAX);
+
+  if (counts[index] > 0 && minute < lastMinutes[index])
+  {
+    heads[index] = 0;
+    counts[index] = 0;
+  }
+
+  // a later quote within the same minute replaces the newest tick
+  if (counts[index] > 0 && minute == lastMinutes[index])
+  {
+    ticks[index][(heads[index] + INTRADAY_SESSION_MINUTES - 1) % INTRADAY_SESSION_MINUTES] = tick;
+    return;
+  }
+
+  if (counts[index] > 0)
+  {
+    int16_t hold = Tick(index, 0);
+    for (uint16_t gap = minute - lastMinutes[index]; gap > 1; gap--)
+      Push(index, hold);
+  }
+  Push(index, tick);
+  lastMinutes[index] = minute;
+}
+
+void IntradayHistory::Push(uint8_t index, int16_t tick)
+{
+  ticks[index][heads[index]] = tick;
+  heads[index] = (heads[index] + 1) % INTRADAY_SESSION_MINUTES;
+  if (counts[index] < INTRADAY_SESSION_MINUTES)
+    counts[index]++;
+  appended[index]++;
+}
+
+uint16_t IntradayHistory::Count(uint8_t index) const
+{
+  return counts[index];
+}
+
+int16_t IntradayHistory::Tick(uint8_t index, uint16_t age) const
+{
+  return ticks[index][(heads[index] + INTRADAY_SESSION_MINUTES - 1 - age) % INTRADAY_SESSION_MINUTES];
+}
+
+uint32_t IntradayHistory::Appended(uint8_t index) const
+{
+  return appended[index];
+}
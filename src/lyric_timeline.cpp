@@ -0,0 +1,146 @@
+#include "lyric_timeline.h"
+
+// parse "mm:ss", "mm:ss.xx" or "mm:ss:xx" between brackets, false for tags like [ar:...]
+static bool ParseLrcTime(const char *data, uint16_t length, uint32_t &ms)
+{
+  uint32_t minutes = 0, seconds = 0, fraction = 0, fractionScale = 1;
+  uint16_t i = 0;
+  bool hasDigits = false;
+  for (; i < length && isdigit((uint8_t)data[i]); i++, hasDigits = true)
+    minutes = minutes * 10 + (data[i] - '0');
+  if (!hasDigits || i >= length || data[i++] != ':')
+    return false;
+
+  hasDigits = false;
+  for (; i < length && isdigit((uint8_t)data[i]); i++, hasDigits = true)
+    seconds = seconds * 10 + (data[i] - '0');
+  if (!hasDigits)
+    return false;
+
+  if (i < length && (data[i] == '.' || data[i] == ':'))
+  {
+    for (i++; i < length && isdigit((uint8_t)data[i]) && fractionScale < 1000; i++)
+    {
+      fraction = fraction * 10 + (data[i] - '0');
+      fractionScale *= 10;
+    }
+  }
+  if (i != length)
+    return false;
+
+  ms = (minutes * 60 + seconds) * 1000 + fraction * 1000 / fractionScale;
+  return true;
+}
+
+void LyricTimeline::Clear()
+{
+  count = 0;
+  blobUsed = 0;
+}
+
+uint8_t LyricTimeline::AddLrcLine(const char *data, uint16_t length)
+{
+  uint32_t stamps[8];
+  uint8_t stampCount = 0;
+  uint16_t i = 0;
+  while (i < length && data[i] == '[')
+  {
+    uint16_t close = i + 1;
+    while (close < length && data[close] != ']')
+      close++;
+    if (close >= length)
+      break;
+
+    uint32_t ms;
+    if (!ParseLrcTime(data + i + 1, close - i - 1, ms))
+      break;
+    if (stampCount < sizeof(stamps) / sizeof(stamps[0]))
+      stamps[stampCount++] = ms;
+    i = close + 1;
+  }
+  if (stampCount == 0)
+  {
+    return 0; // metadata tag or plain text
+  }
+
+  uint16_t textLength = length - i;
+  while (textLength > 0 && (data[i + textLength - 1] == '\r' || data[i + textLength - 1] == '\n'))
+    textLength--;
+  if (blobUsed + textLength + 1 > LYRIC_TIMELINE_BLOB_SIZE || count + stampCount > LYRIC_TIMELINE_MAX_LINES)
+  {
+    droppedLines++;
+    return 0;
+  }
+
+  uint16_t offset = blobUsed;
+  memcpy(blob + offset, data + i, textLength);
+  blob[offset + textLength] = '\0';
+  blobUsed += textLength + 1;
+
+  for (uint8_t s = 0; s < stampCount; s++)
+  {
+    Insert(stamps[s], offset);
+  }
+  return stampCount;
+}
+
+int16_t LyricTimeline::Find(uint32_t positionMs)
+{
+  // last entry with ms <= position
+  int16_t low = 0, high = count - 1, found = -1;
+  while (low <= high)
+  {
+    int16_t mid = (low + high) / 2;
+    if (entries[mid].ms <= positionMs)
+    {
+      found = mid;
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid - 1;
+    }
+  }
+  return found;
+}
+
+uint16_t LyricTimeline::Count()
+{
+  return count;
+}
+
+const char *LyricTimeline::Line(int16_t index)
+{
+  if (index < 0 || index >= count)
+  {
+    return "";
+  }
+  return blob + entries[index].offset;
+}
+
+uint32_t LyricTimeline::LineMs(int16_t index)
+{
+  if (index < 0 || index >= count)
+  {
+    return UINT32_MAX;
+  }
+  return entries[index].ms;
+}
+
+uint32_t LyricTimeline::DroppedLines()
+{
+  return droppedLines;
+}
+
+void LyricTimeline::Insert(uint32_t ms, uint16_t offset)
+{
+  // lines normally arrive in order, so this is an append
+  uint16_t i = count;
+  while (i > 0 && entries[i - 1].ms > ms)
+  {
+    entries[i] = entries[i - 1];
+    i--;
+  }
+  entries[i] = {ms, offset};
+  count++;
+}
@@ -7,11 +7,53 @@
 #include <ArduinoJson.h>
 #include <Preferences.h>
 #include "time.h"
+#include <sys/time.h>
 #include "secrets.h"
 #include "wifi_info.h"
-
-#define FINANCE_TOTAL_COUNT 5 // stock + currency
-#define STOCK_COUNT 3
+#include "compositor.h"
+#include "glyph_cache.h"
+#include "serial_rx.h"
+#include "player_link.h"
+#include "lyric_timeline.h"
+#include "position_clock.h"
+#include "http_pool.h"
+#include "snapshot.h"
+#include "render_scheduler.h"
+#include "render_bench.h"
+#include "telemetry.h"
+#include "watchlist.h"
+#include "http_scheduler.h"
+#include "market_cache.h"
+#include "intraday_history.h"
+#include "sparkline.h"
+#include "digit_atlas.h"
+#include "marquee.h"
+#include "boot_log.h"
+#include "quote_poller.h"
+#include "album_art.h"
+#include "spectrum.h"
+
+#define TWSE_BATCH_SIZE 10 // stocks per getStockInfo request
+#define HTTP_PRIORITY_REFRESH 1   // whole watchlist, currencies
+#define HTTP_PRIORITY_WEATHER 2   // hourly, can wait behind everything else
+#define STALE_COLOR TFT_DARKGREY // cached values not refreshed since boot
+#define SONG_BAR_WIDTH 150
+#define PLAYER_LINE_WIDTH 155 // lyric line, canvas width less x_pad
+#define ALBUM_ART_X (160 - ALBUM_ART_SIZE - 5) // right of the metadata lines, canvas width less x_pad
+#define ALBUM_ART_Y 62
+#define PLAYER_METADATA_WIDTH (ALBUM_ART_X - 4 - 5) // metadata lines stop 4 px short of the art
+#ifndef SERIAL_BAUD_RATE
+#define SERIAL_BAUD_RATE 115200 // host must match, use 921600 for high rate binary updates
+#endif
+#ifndef STATS_LOG_INTERVAL_SEC
+#define STATS_LOG_INTERVAL_SEC 0 // 0 = only on request (9$0$), the lines share the player link
+#endif
+#ifndef BOOT_FIRST_FRAME_BUDGET_MS
+#define BOOT_FIRST_FRAME_BUDGET_MS 500 // reset to the main screen drawn from cached data
+#endif
+#ifndef RENDER_BENCH_BUDGET_US
+#define RENDER_BENCH_BUDGET_US 20000 // -D RENDER_BENCH: max time one routine may take per frame, push included
+#endif
 
 /*
 **Upload settings**
@@ -25,20 +67,24 @@ Upload Speed: 921600
 
 //**FreeRTOS**
 TaskHandle_t taskHttpGet;
-QueueHandle_t queueHttpGet;
 enum RequestHttpGetType
 {
   Weather,
   TWSE,
   Currency
 };
-struct RequestHttpGet
-{
-  RequestHttpGetType type;
-  uint8_t index;
-};
-RequestHttpGet httpGetReq;
+HttpScheduler httpScheduler; // pending requests for the HTTP task, coalesced by type and index
 Preferences preferences;
+Preferences cachePreferences; // HTTP task's own handle for the market cache
+MarketCache marketCache;      // last known data in NVS, HTTP task only after setup
+Snapshot<MarketCacheStats> marketCacheStatsSnapshot; // published by the HTTP task for PrintStats
+QuotePoller quotePoller;      // when to ask TWSE for which stock, HTTP task only
+JsonDocument httpJsonFilters[3]; // per RequestHttpGetType, only displayed fields are kept
+uint32_t httpPeakHeap[3];        // per RequestHttpGetType, bytes of heap used at most by one request
+HttpHostStats httpTypeStats[3];  // per RequestHttpGetType, latency of whole requests including parsing
+const char *httpTypeNames[3] = {"weather", "twse", "currency"};
+HttpPool httpPool;               // keep-alive connection per host, HTTP task only
+RenderScheduler renderScheduler; // loop() sleeps until the second tick, serial or HTTP data
 //**FreeRTOS**
 
 //**WiFi**
@@ -51,46 +97,110 @@ const char *ntpServer = "pool.ntp.org";
 const long gmtOffset_sec = 28800; // GMT+8
 const int daylightOffset_sec = 0;
 struct tm timeinfo;
+bool isClockSynced = false; // timeinfo is 1970 until the first NTP answer
 uint8_t secPrev, minPrev, hourPrev, dayPrev;
-bool isWorkingDay;
 //**NTP**
 
+//**Boot**
+enum BootPhase
+{
+  BootDisplay,
+  BootCache,
+  BootFirstFrame,
+  BootWifi,
+  BootClock,
+  BootQuotes,
+  BootWeather,
+  BootPhaseCount
+};
+const char *bootPhaseNames[BootPhaseCount] = {"display", "cache", "first frame", "wifi", "clock", "quotes", "weather"};
+BootLog bootLog; // time to each phase, network phases come up in the background
+bool isWeatherRequestedAtBoot = false; // the first hourly weather request is already out
+//**Boot**
+
 //**TFT**
 TFT_eSPI tft = TFT_eSPI(); // Invoke library, pins defined in User_Setup.h
+TFT_eSprite canvas = TFT_eSprite(&tft); // RAM framebuffer, every widget draws here
+Compositor compositor(tft, canvas);     // pushes dirty regions of canvas once per frame
+GlyphCache glyphCache(&tft);            // Cubic12 stays loaded, rendered glyphs are cached
+DigitAtlas clockAtlas(&tft);            // font 7 clock digits, rendered once at boot
+uint8_t clockDigitsShown[4] = {255, 255, 255, 255}; // hh mm cells on the canvas, 255 = not drawn
 enum ScreenState
 {
   NoneScreen = -1,
   MainScreen,
-  PlayerScreen
+  PlayerScreen,
+  SpectrumScreen // band levels streamed by the host, screen SPECTRUM_SCREEN
 };
 ScreenState screenState = NoneScreen;
 uint8_t x_pad = 5, y_pad = 5;
+enum Widget
+{
+  WidgetDate,
+  WidgetTime,
+  WidgetSecBlink,
+  WidgetTimeSec,
+  WidgetWeather,
+  WidgetFinance,
+  WidgetPlayerState,
+  WidgetCodec,
+  WidgetDuration,
+  WidgetPosition,
+  WidgetGeneralInfo,
+  WidgetMetadata,
+  WidgetLyric,
+  WidgetLyricTimeline,
+  WidgetMarquee,
+  WidgetFlush,
+  WidgetCount
+};
+const char *widgetNames[WidgetCount] = {"date", "time", "sec blink", "time sec", "weather", "finance", "player state", "codec",
+                                        "duration", "position", "general info", "metadata", "lyric", "lyric timeline", "marquee", "flush"};
+Telemetry telemetry; // metrics on request over the player link, render time per widget
 //**TFT**
 
 //**Open weather data**
 String weatherApiUrl = "http://api.weatherapi.com/v1/current.json?q=Sanchung&aqi=no&lang=zh_tw&key=" + String(WEATHER_API_KEY);
-bool isWeatherPrinted = true;
-float weatherTemp = 0;
-int weatherHumi = 0;
-String weatherDesc = "";
+struct WeatherData
+{
+  float temp;
+  int humi;
+  char desc[64];
+  bool isCached; // restored from flash, not fetched since boot
+};
+Snapshot<WeatherData> weatherSnapshot; // published by the HTTP task
+uint32_t weatherVersionPrinted = 0;
 //**Open weather data**
 
 //**Finance data**
-String currencyApiUrlLatest = "https://api.currencyapi.com/v3/latest?apikey=" + String(CURRENCY_API_KEY) + "&base_currency=TWD&currencies=JPY,USD";
-String currencyApiUrlHistorical = "https://api.currencyapi.com/v3/historical?apikey=" + String(CURRENCY_API_KEY) + "&base_currency=TWD&currencies=JPY,USD&date=";
+String currencyApiUrlLatest = "https://api.currencyapi.com/v3/latest?apikey=" + String(CURRENCY_API_KEY) + "&base_currency=TWD&currencies=";
+String currencyApiUrlHistorical = "https://api.currencyapi.com/v3/historical?apikey=" + String(CURRENCY_API_KEY) + "&base_currency=TWD&currencies=";
 uint8_t financeIndex = 0;
 uint8_t financeIndexPrev = -1;
 bool isFinancePrinted = true;
-bool isTWSEOpening = false;
 int currencyUpdateDate;
-// si_ = stock index; se_ = stock ETF; sn_ = stock normal; cu_ = currency;
-String financeNumbers[FINANCE_TOTAL_COUNT] = {"si_t00", "se_0050", "sn_2330", "cu_JPY", "cu_USD"};
-String financeNames[FINANCE_TOTAL_COUNT] = {"加權指數", "元大台灣50", "台積電", "日幣_台幣 JPY_TWD", "美元_台幣 USD_TWD"};
-float financePrices[FINANCE_TOTAL_COUNT];
-float financeYesterdayPrices[FINANCE_TOTAL_COUNT];
+Watchlist watchlist;                   // loop task's list, edited over serial
+Snapshot<Watchlist> watchlistSnapshot; // published after every edit
+Watchlist httpWatchlist;               // HTTP task's copy, prices are indexed by it
+struct FinanceData
+{
+  uint32_t watchlistVersion; // watchlistSnapshot version the indexes belong to
+  float prices[WATCHLIST_MAX_SYMBOLS];
+  float yesterdayPrices[WATCHLIST_MAX_SYMBOLS];
+  bool isCached[WATCHLIST_MAX_SYMBOLS]; // restored from flash, not fetched since boot
+};
+FinanceData financeLatest;             // HTTP task's working copy, published after every change
+Snapshot<FinanceData> financeSnapshot; // what the render loop draws
+uint32_t financeVersionPrinted = 0;
+IntradayHistory intradayHistory; // loop task, one tick per minute from the finance snapshot
+uint32_t financeVersionRecorded = 0;
+Sparkline financeSparkline(canvas, compositor, x_pad + 110, y_pad + 91, 40, 14); // right of the finance name
 //**Finanse data**
 
 //**Player info**
+SerialRx serialRx;     // bytes from the PC, framed without blocking loop()
+PlayerLink playerLink; // text or binary frames on top of serialRx
+PlayerLinkLog linkLog; // diagnostic lines, framed while the link is binary
 enum PlayerInfoId
 {
   None = -1,
@@ -104,7 +214,10 @@ enum PlayerInfoId
   Duration,
   Position,
   PlaybackState,
-  LyricCurrent
+  LyricCurrent,
+  LyricClear, // start of a new LRC upload
+  LyricLine,  // one LRC line "[mm:ss.xx]text", sent for the whole song after LyricClear
+  AlbumArtData // binary frames only, see album_art.h
 };
 enum PlayerState
 {
@@ -118,30 +231,82 @@ String songArtist = "";
 String songTitle = "";
 String songAlbum = "";
 int songDuration = 0;
-int songPostion = 0;
+PositionClock songPositionClock; // extrapolated locally, host positions are sync points
+int32_t songPositionSecPrinted = -1; // -1 = redraw
+int16_t songBarColumnPrev = -1;      // -1 = redraw whole bar
 String songBitDepth = "0";
 String songBitrate = "0";
 String songSampleRate = "0";
 String songCodec = "";
 String songCurrentLyric = "";
+LyricTimeline lyricTimeline;
+TFT_eSprite lyricNextSprite = TFT_eSprite(&tft); // next lyric line, rendered ahead of its time
+int16_t lyricIndexPrev = -2;                     // -1 = before first line, -2 = force redraw
+int16_t lyricPrerenderedIndex = -2;
 int songMetadataYPosOffset = 58; // for tft print
+// text longer than its line scrolls, rows 16 px high with the text 2 px down like the lines they replace
+MarqueeStrip marqueeStrip(&tft, 16);
+Marquee artistMarquee(marqueeStrip, x_pad, y_pad + songMetadataYPosOffset - 2, PLAYER_METADATA_WIDTH, 2);
+Marquee albumMarquee(marqueeStrip, x_pad, y_pad + songMetadataYPosOffset - 2 + 17, PLAYER_METADATA_WIDTH, 2);
+Marquee titleMarquee(marqueeStrip, x_pad, y_pad + songMetadataYPosOffset - 2 + 34, PLAYER_METADATA_WIDTH, 2);
+Marquee lyricMarquee(marqueeStrip, x_pad, 114, PLAYER_LINE_WIDTH, 2);
+Marquee *songMetadataMarquees[3] = {&artistMarquee, &albumMarquee, &titleMarquee};
+MarqueeGroup playerMarquees;
+AlbumArt albumArt(&tft); // thumbnail sent in chunks by the host, cached per track
 //**Player info**
 
+//**Spectrum**
+Spectrum spectrum(canvas, compositor, x_pad, y_pad, 150, 118); // the whole canvas less the padding
+//**Spectrum**
+
 // **Utils**
-void ClearScreen(int startPoint, int endPoint, int perUnit)
+// yyyymmdd, as currencyUpdateDate is stored
+int DateNumber(const struct tm &date)
+{
+  return (date.tm_year + 1900) * 10000 + (date.tm_mon + 1) * 100 + date.tm_mday;
+}
+
+void ClearScreen()
 {
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  for (int i = startPoint; i <= endPoint; i += perUnit)
+  compositor.Clear(TFT_BLACK);
+}
+
+void CanvasClearArea(int32_t x, int32_t y, int32_t w, int32_t h)
+{
+  canvas.fillRect(x, y, w, h, TFT_BLACK);
+  compositor.MarkDirty(x, y, w, h);
+}
+
+// draw string on canvas and mark its bounding box dirty, returns string width
+int16_t CanvasDrawString(const String &str, int32_t x, int32_t y, uint8_t font)
+{
+  int16_t width = canvas.drawString(str, x, y, font);
+  compositor.MarkDirty(x, y, width, canvas.fontHeight(font));
+  return width;
+}
+
+// scroll a string too long for its line, first window drawn now, false when it fits and nothing started
+bool CanvasStartMarquee(Marquee &marquee, const char *str, uint16_t length)
+{
+  if (!marquee.Start(glyphCache, str, length, 0xFFFF, TFT_BLACK))
   {
-    tft.setCursor(0, i);
-    tft.println("                                   ");
+    return false;
   }
-  tft.setCursor(0, 0);
+  marquee.Step(compositor, millis());
+  return true;
+}
+
+// draw Cubic12 (han character) string on canvas through the glyph cache, returns string width
+int16_t CanvasDrawSmoothString(const String &str, int32_t x, int32_t y, uint16_t fg, uint16_t bg = TFT_BLACK)
+{
+  int16_t width = glyphCache.DrawString(canvas, str, x, y, fg, bg);
+  compositor.MarkDirty(x, y, width, glyphCache.LineHeight());
+  return width;
 }
 
 void IncreaseFinanceIndex()
 {
-  if (financeIndex >= FINANCE_TOTAL_COUNT - 1)
+  if (financeIndex >= watchlist.Count() - 1)
   {
     financeIndex = 0;
   }
@@ -151,131 +316,333 @@ void IncreaseFinanceIndex()
   }
 }
 
+void SetupHttpJsonFilters()
+{
+  httpJsonFilters[Weather]["current"]["temp_c"] = true;
+  httpJsonFilters[Weather]["current"]["humidity"] = true;
+  httpJsonFilters[Weather]["current"]["condition"]["text"] = true;
+
+  httpJsonFilters[TWSE]["msgArray"][0]["c"] = true;
+  httpJsonFilters[TWSE]["msgArray"][0]["z"] = true;
+  httpJsonFilters[TWSE]["msgArray"][0]["y"] = true;
+  httpJsonFilters[TWSE]["msgArray"][0]["tlong"] = true;
+
+  httpJsonFilters[Currency]["data"]["*"]["value"] = true;
+}
+
+// heap left and its largest block, the budget for a TLS session is what remains after setup
+void LogHeap(const char *when)
+{
+  linkLog.printf("[HEAP] %s: %u B free, largest block %u B\n", when, ESP.getFreeHeap(), ESP.getMaxAllocHeap());
+}
+
+// GET url and parse its JSON body through the filter of type, false when the request failed
+bool HttpGetJson(const String &url, RequestHttpGetType type, JsonDocument &doc, uint32_t idleMs = HTTP_POOL_IDLE_MS)
+{
+  uint32_t heapBefore = ESP.getFreeHeap();
+  uint32_t heapLowest = heapBefore;
+  int64_t startMicros = esp_timer_get_time();
+
+  bool isOk = httpPool.Get(url, idleMs) == HTTP_CODE_OK;
+  static bool isTlsHeapLogged = false;
+  if (isOk && !isTlsHeapLogged && url.startsWith("https"))
+  {
+    LogHeap("first TLS session");
+    isTlsHeapLogged = true;
+  }
+  if (isOk)
+  {
+    heapLowest = min(heapLowest, ESP.getFreeHeap());
+    isOk = !deserializeJson(doc, httpPool.Body(), DeserializationOption::Filter(httpJsonFilters[type]));
+    heapLowest = min(heapLowest, ESP.getFreeHeap());
+  }
+  else
+  {
+    linkLog.println("HTTP GET failed.");
+  }
+  httpPool.End();
+
+  httpPeakHeap[type] = max(httpPeakHeap[type], heapBefore - heapLowest);
+  HttpRecordRequest(httpTypeStats[type], (esp_timer_get_time() - startMicros) / 1000, isOk);
+  return isOk;
+}
+
+// one getStockInfo request for the stocks at indexes
+String TwseQuotesUrl(const uint8_t *indexes, uint8_t count)
+{
+  String url = "https://mis.twse.com.tw/stock/api/getStockInfo.jsp?ex_ch=";
+  for (uint8_t k = 0; k < count; k++)
+  {
+    if (k > 0)
+      url += "%7C"; // '|'
+    url += "tse_" + String(httpWatchlist.Symbol(indexes[k])) + ".tw";
+  }
+  return url;
+}
+
+// ms since the epoch, tlong of a TWSE quote is in the same unit
+uint64_t EpochMillis()
+{
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return (uint64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+// update every stock at indexes found in msgArray, matched by its code, true when any changed
+bool UpdateTwseQuotes(JsonDocument &doc, const uint8_t *indexes, uint8_t count)
+{
+  bool isChanged = false;
+  bool isFound[TWSE_BATCH_SIZE] = {};
+  uint64_t nowEpochMs = EpochMillis();
+  for (JsonObject quote : doc["msgArray"].as<JsonArray>())
+  {
+    const char *code = quote["c"] | "";
+    for (uint8_t k = 0; k < count; k++)
+    {
+      uint8_t i = indexes[k];
+      if (strcmp(httpWatchlist.Symbol(i), code) != 0)
+        continue;
+
+      // time of the last trade, the poller asks more often while it moves
+      quotePoller.Polled(i, strtoull(quote["tlong"] | "0", nullptr, 10), nowEpochMs, millis());
+      isFound[k] = true;
+
+      // "-" = no trade yet, keep previous price
+      float price = quote["z"] != "-" ? quote["z"].as<float>() : financeLatest.prices[i];
+      float yesterdayPrice = quote["y"].as<float>();
+      if (price != financeLatest.prices[i] || yesterdayPrice != financeLatest.yesterdayPrices[i] || financeLatest.isCached[i])
+      {
+        financeLatest.prices[i] = price;
+        financeLatest.yesterdayPrices[i] = yesterdayPrice;
+        financeLatest.isCached[i] = false;
+        isChanged = true;
+      }
+    }
+  }
+  // missing from the answer, polled less often like a stock that does not trade
+  for (uint8_t k = 0; k < count; k++)
+  {
+    if (!isFound[k])
+      quotePoller.Polled(indexes[k], 0, nowEpochMs, millis());
+  }
+  return isChanged;
+}
+
+// "JPY,USD" for the currencies in the HTTP task's watchlist
+String CurrencyCodes()
+{
+  String codes;
+  for (uint8_t i = httpWatchlist.StockCount(); i < httpWatchlist.Count(); i++)
+  {
+    if (codes.length())
+      codes += ",";
+    codes += httpWatchlist.Symbol(i);
+  }
+  return codes;
+}
+
+// take over an edited watchlist, prices move with their symbols, new ones start empty
+void SyncHttpWatchlist()
+{
+  if (watchlistSnapshot.Version() == financeLatest.watchlistVersion)
+  {
+    return;
+  }
+
+  static Watchlist updated;
+  static FinanceData remapped;
+  remapped = {};
+  remapped.watchlistVersion = watchlistSnapshot.Read(updated);
+  for (uint8_t i = 0; i < updated.Count(); i++)
+  {
+    int16_t old = httpWatchlist.Find(updated.Type(i), updated.Symbol(i));
+    if (old >= 0)
+    {
+      remapped.prices[i] = financeLatest.prices[old];
+      remapped.yesterdayPrices[i] = financeLatest.yesterdayPrices[old];
+      remapped.isCached[i] = financeLatest.isCached[old];
+    }
+  }
+  httpWatchlist = updated;
+  financeLatest = remapped;
+  financeSnapshot.Publish(financeLatest);
+  quotePoller.Reset();
+}
+
+// never blocks the caller, live TWSE quotes are not requested here but polled by the HTTP task
+void RequestHttpGet(RequestHttpGetType type, uint8_t index)
+{
+  switch (type)
+  {
+  case Weather:
+    httpScheduler.Submit(Weather, index, HTTP_PRIORITY_WEATHER);
+    break;
+  case TWSE:
+    httpScheduler.Submit(TWSE, HTTP_JOB_ALL, HTTP_PRIORITY_REFRESH);
+    break;
+  case Currency:
+    httpScheduler.Submit(Currency, index, HTTP_PRIORITY_REFRESH);
+    break;
+  }
+}
+
+// HTTP task only
+void FetchTwseQuotes(const uint8_t *indexes, uint8_t count)
+{
+  JsonDocument doc;
+  // quiet symbols back off to one request a minute, the socket stays open for them
+  if (HttpGetJson(TwseQuotesUrl(indexes, count), TWSE, doc, QUOTE_POLL_MAX_MS + HTTP_POOL_IDLE_MS) && UpdateTwseQuotes(doc, indexes, count))
+  {
+    financeSnapshot.Publish(financeLatest);
+    renderScheduler.Notify(RENDER_EVENT_HTTP);
+    marketCache.StageQuotes(httpWatchlist, financeLatest.prices, financeLatest.yesterdayPrices);
+    bootLog.Mark(BootQuotes);
+  }
+}
+
+// the stocks the poller finds due, nothing before the clock is set
+void PollTwseQuotes()
+{
+  struct tm now;
+  if (!getLocalTime(&now, 0))
+    return;
+
+  SyncHttpWatchlist();
+  uint8_t indexes[TWSE_BATCH_SIZE];
+  uint8_t count = quotePoller.Due(now, millis(), httpWatchlist.StockCount(), indexes, TWSE_BATCH_SIZE);
+  if (count > 0)
+    FetchTwseQuotes(indexes, count);
+}
+
+// one blob write for everything staged, HTTP task only
+void SaveMarketCache(bool isForced)
+{
+  if (marketCache.IsCommitDue(isForced))
+  {
+    cachePreferences.begin("storage");
+    marketCache.Commit(cachePreferences, "market");
+    cachePreferences.end();
+  }
+  marketCacheStatsSnapshot.Publish(marketCache.Stats()); // merged changes count without a commit too
+}
+
 // **Callbacks**
 void vTaskHttpGetCallback(void *pvParameters)
 {
+  SetupHttpJsonFilters();
+
+  // jobs queue up meanwhile, the screen runs on cached data
+  while (WiFi.status() != WL_CONNECTED)
+  {
+    vTaskDelay(pdMS_TO_TICKS(100));
+  }
+  bootLog.Mark(BootWifi);
+
   while (true)
   {
-    RequestHttpGet req;
-    uint8_t twseIndexPrev;
-    if (xQueueReceive(queueHttpGet, &req, 1000) == pdTRUE)
+    HttpJob req;
+    if (httpScheduler.Take(req, 1000))
     {
-      HTTPClient http;
       switch (req.type)
       {
       case Weather:
       {
-        http.begin(weatherApiUrl);
+        JsonDocument doc;
+        if (HttpGetJson(weatherApiUrl, Weather, doc))
+        {
+          WeatherData weather = {};
+          weather.temp = doc["current"]["temp_c"].as<float>();
+          weather.humi = doc["current"]["humidity"].as<int>();
+          strlcpy(weather.desc, doc["current"]["condition"]["text"] | "", sizeof(weather.desc));
+          weatherSnapshot.Publish(weather);
+          renderScheduler.Notify(RENDER_EVENT_HTTP);
+          marketCache.StageWeather(weather.temp, weather.humi, weather.desc);
+          bootLog.Mark(BootWeather);
+        }
       }
       break;
       case TWSE:
       {
-        if (req.index == 255) // 255 = update all
+        SyncHttpWatchlist();
+        // whole watchlist, a batch per request
+        uint8_t stockCount = httpWatchlist.StockCount();
+        for (uint8_t start = 0; start < stockCount; start += TWSE_BATCH_SIZE)
         {
-          // queue all TWSE indexes
-          for (uint8_t i = 0; i < STOCK_COUNT; i++)
-          {
-            req.index = i;
-            xQueueSend(queueHttpGet, &req, 100);
-          }
-          twseIndexPrev = 255;
-          continue;
+          uint8_t indexes[TWSE_BATCH_SIZE];
+          uint8_t count = min(TWSE_BATCH_SIZE, stockCount - start);
+          for (uint8_t k = 0; k < count; k++)
+            indexes[k] = start + k;
+          FetchTwseQuotes(indexes, count);
         }
-        http.begin("https://mis.twse.com.tw/stock/api/getStockInfo.jsp?ex_ch=tse_" + financeNumbers[req.index].substring(3) + ".tw");
       }
       break;
       case Currency:
       {
+        // own clock read, timeinfo belongs to the loop; no date for the cache before the clock is set
+        struct tm now;
+        if (!getLocalTime(&now, 0))
+          break;
+        SyncHttpWatchlist();
+        if (httpWatchlist.StockCount() == httpWatchlist.Count())
+          break;
+
+        String url;
         if (req.index == 0)
         {
-          http.begin(currencyApiUrlLatest);
+          url = currencyApiUrlLatest + CurrencyCodes();
         }
         else if (req.index == 1)
         {
-          struct tm tempTM = timeinfo;
+          struct tm tempTM = now;
           tempTM.tm_hour -= 8; // gmt+8 to utc
           tempTM.tm_mday -= 2;
           mktime(&tempTM);
           char previousDateBuffer[11];
           strftime(previousDateBuffer, sizeof(previousDateBuffer), "%Y-%m-%d", &tempTM);
-          http.begin(currencyApiUrlHistorical + previousDateBuffer);
+          url = currencyApiUrlHistorical + CurrencyCodes() + "&date=" + previousDateBuffer;
         }
-      }
-      break;
-      }
 
-      if (http.GET() == HTTP_CODE_OK)
-      {
-        String payload;
         JsonDocument doc;
-        payload = http.getString();
-        deserializeJson(doc, payload);
+        if (!HttpGetJson(url, Currency, doc))
+          break;
 
-        switch (req.type)
-        {
-        case Weather:
-        {
-          weatherTemp = doc["current"]["temp_c"].as<float>();
-          weatherHumi = doc["current"]["humidity"].as<int>();
-          weatherDesc = doc["current"]["condition"]["text"].as<String>();
-          isWeatherPrinted = false;
-        }
-        break;
-        case TWSE:
+        bool isUpdated = false;
+        for (uint8_t i = httpWatchlist.StockCount(); i < httpWatchlist.Count(); i++)
         {
-          // update specific index of stock
-          float financePricePrev = financePrices[req.index];
-          float financePriceNew = doc["msgArray"][0]["z"] != "-" ? doc["msgArray"][0]["z"].as<float>() : financePricePrev;
-          // update value only when [value is different] or [changing to next index] or [update all value mode(255)]
-          if (req.index == twseIndexPrev && financePricePrev != financePriceNew ||
-              req.index != twseIndexPrev && twseIndexPrev < 255 ||
-              twseIndexPrev == 255)
+          // unknown codes and partial answers have no value, their last price stays
+          float value = doc["data"][httpWatchlist.Symbol(i)]["value"] | 0.0F;
+          float fetchedPrice = 1 / value;
+          if (!(value > 0) || !isfinite(fetchedPrice))
+            continue;
+          if (req.index == 0)
           {
-            financePrices[req.index] = financePriceNew;
-            financeYesterdayPrices[req.index] = doc["msgArray"][0]["y"].as<float>();
-            // when [update all value mode is on(255)] update twseIndexPrev only when index is last one(finish update all)
-            // or normally update twseIndexPrev
-            if ((twseIndexPrev == 255 && req.index == STOCK_COUNT - 1) || twseIndexPrev < 255)
-            {
-              twseIndexPrev = req.index;
-              isFinancePrinted = false;
-            }
+            financeLatest.yesterdayPrices[i] = financeLatest.prices[i];
+            financeLatest.prices[i] = fetchedPrice;
           }
-        }
-        break;
-        case Currency:
-        {
-          preferences.begin("storage");
-
-          for (uint8_t i = STOCK_COUNT; i < FINANCE_TOTAL_COUNT; i++)
+          else if (req.index == 1)
           {
-            float fetchedPrice = 1 / doc["data"][financeNumbers[i].substring(3)]["value"].as<float>();
-            if (req.index == 0)
-            {
-              financeYesterdayPrices[i] = financePrices[i];
-              financePrices[i] = fetchedPrice;
-              preferences.putFloat(("c_y_" + String(i)).c_str(), financeYesterdayPrices[i]);
-              preferences.putFloat(("c_" + String(i)).c_str(), financePrices[i]);
-            }
-            else if (req.index == 1)
-            {
-              financeYesterdayPrices[i] = fetchedPrice;
-              preferences.putFloat(("c_y_" + String(i)).c_str(), financeYesterdayPrices[i]);
-            }
-            currencyUpdateDate = (timeinfo.tm_year + 1900) * 10000 + (timeinfo.tm_mon + 1) * 100 + timeinfo.tm_mday;
-            preferences.putUInt("c_date", currencyUpdateDate);
-            preferences.end();
+            financeLatest.yesterdayPrices[i] = fetchedPrice;
           }
+          financeLatest.isCached[i] = false;
+          isUpdated = true;
         }
-        break;
-        }
+        if (!isUpdated)
+          break; // nothing usable, the old date keeps the rates shown as stale
+        currencyUpdateDate = DateNumber(now);
+        financeSnapshot.Publish(financeLatest);
+        renderScheduler.Notify(RENDER_EVENT_HTTP);
+
+        // daily, written at once so the date is never ahead of the stored prices
+        marketCache.StageQuotes(httpWatchlist, financeLatest.prices, financeLatest.yesterdayPrices);
+        marketCache.StageCurrencyDate(currencyUpdateDate);
+        SaveMarketCache(true);
       }
-      else
-      {
-        Serial.println("HTTP GET failed.");
+      break;
       }
-      http.end();
     }
+
+    PollTwseQuotes();
+    SaveMarketCache(false);
   }
 }
 
@@ -383,42 +750,44 @@ int TextBackgroundColorByCodec(String codecStr)
 // **Time & Date**
 void TFTPrintTime()
 {
+  TelemetrySpan span(telemetry, WidgetTime);
   int xposTime = x_pad + 5;
   int yposTime = y_pad + 15;
 
-  // print time
-  tft.setTextColor(0x39C4, TFT_BLACK);
-  tft.drawString("88 88", xposTime, yposTime, 7);
-  tft.setTextColor(0xFFFF);
-  if (timeinfo.tm_hour < 10)
-    xposTime += tft.drawChar('0', xposTime, yposTime, 7);
-  xposTime += tft.drawNumber(timeinfo.tm_hour, xposTime, yposTime, 7);
-  xposTime += tft.drawChar(' ', xposTime, yposTime, 7);
-  if (timeinfo.tm_min < 10)
-    xposTime += tft.drawChar('0', xposTime, yposTime, 7);
-  xposTime += tft.drawNumber(timeinfo.tm_min, xposTime, yposTime, 7);
+  // blit only the cells that changed, hh and mm are a font 7 space apart
+  uint8_t digits[4] = {(uint8_t)(timeinfo.tm_hour / 10), (uint8_t)(timeinfo.tm_hour % 10),
+                       (uint8_t)(timeinfo.tm_min / 10), (uint8_t)(timeinfo.tm_min % 10)};
+  int16_t digitWidth = clockAtlas.DigitWidth();
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    if (digits[i] == clockDigitsShown[i])
+      continue;
+    int xposDigit = xposTime + i * digitWidth + (i >= 2 ? canvas.textWidth(" ", 7) : 0);
+    clockAtlas.DrawDigit(canvas, digits[i], xposDigit, yposTime);
+    compositor.MarkDirty(xposDigit, yposTime, digitWidth, clockAtlas.Height());
+    clockDigitsShown[i] = digits[i];
+  }
 }
 
 void TFTPrintSecBlink()
 {
-  // print ":" background
-  tft.setTextColor(0x39C4, TFT_BLACK);
-  tft.drawString(":", x_pad + 70, y_pad + 15, 7);
-
-  // print ":" (blink it)
-  tft.setTextColor(0xFFFF);
-  tft.drawChar(timeinfo.tm_sec % 2 == 0 ? ':' : ' ', x_pad + 70, y_pad + 15, 7);
+  TelemetrySpan span(telemetry, WidgetSecBlink);
+  // lit on even seconds, ghosted on odd ones
+  int16_t colonWidth = clockAtlas.DrawColon(canvas, timeinfo.tm_sec % 2 == 0, x_pad + 70, y_pad + 15);
+  compositor.MarkDirty(x_pad + 70, y_pad + 15, colonWidth, clockAtlas.Height());
 }
 
 void TFTPrintTimeSec()
 {
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  tft.drawString((timeinfo.tm_sec < 10 ? "0" : "") + String(timeinfo.tm_sec), x_pad + 130, y_pad, 1);
+  TelemetrySpan span(telemetry, WidgetTimeSec);
+  canvas.setTextColor(0xFFFF, TFT_BLACK);
+  CanvasDrawString((timeinfo.tm_sec < 10 ? "0" : "") + String(timeinfo.tm_sec), x_pad + 130, y_pad, 1);
 }
 
 void TFTPrintDate()
 {
-  tft.setTextColor(0xFFFF, TFT_BLACK);
+  TelemetrySpan span(telemetry, WidgetDate);
+  canvas.setTextColor(0xFFFF, TFT_BLACK);
   String dayOfWeekStr;
   switch (timeinfo.tm_wday)
   {
@@ -444,249 +813,379 @@ void TFTPrintDate()
     dayOfWeekStr = "SAT.";
     break;
   }
-  tft.drawString(String(timeinfo.tm_year + 1900) + "/" + (timeinfo.tm_mon < 9 ? "0" : "") + String(timeinfo.tm_mon + 1) + "/" + (timeinfo.tm_mday < 10 ? "0" : "") + String(timeinfo.tm_mday) + " " + dayOfWeekStr + "  ",
-                 x_pad + 5, y_pad, 1);
+  CanvasDrawString(String(timeinfo.tm_year + 1900) + "/" + (timeinfo.tm_mon < 9 ? "0" : "") + String(timeinfo.tm_mon + 1) + "/" + (timeinfo.tm_mday < 10 ? "0" : "") + String(timeinfo.tm_mday) + " " + dayOfWeekStr + "  ",
+                   x_pad + 5, y_pad, 1);
 }
 
 // **Weather**
 void TFTPrintOpenWeatherInfo()
 {
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  tft.drawString("                                    ", x_pad, y_pad + 70, 2);
+  TelemetrySpan span(telemetry, WidgetWeather);
+  WeatherData weather;
+  weatherVersionPrinted = weatherSnapshot.Read(weather);
 
-  tft.loadFont(Cubic12);
+  CanvasClearArea(x_pad, y_pad + 70, canvas.width() - x_pad, 16);
 
-  // print description
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  tft.drawString(weatherDesc, x_pad + 5, y_pad + 72);
+  // print description, all of it greyed out while it is the cached one
+  CanvasDrawSmoothString(weather.desc, x_pad + 5, y_pad + 72, weather.isCached ? STALE_COLOR : 0xFFFF);
 
   // print temperature
-  tft.setTextColor(TextColorByTemperature(weatherTemp), TFT_BLACK);
-  tft.drawString((weatherTemp >= 10 ? "" : " ") + String(weatherTemp, 1) + "℃", x_pad + 80, y_pad + 72);
+  CanvasDrawSmoothString((weather.temp >= 10 ? "" : " ") + String(weather.temp, 1) + "℃", x_pad + 80, y_pad + 72,
+                         weather.isCached ? STALE_COLOR : TextColorByTemperature(weather.temp));
 
   // print humidity
-  tft.setTextColor(TextColorByHumidity(weatherHumi), TFT_BLACK);
-  tft.drawString((weatherHumi >= 10 ? "" : " ") + String(weatherHumi) + "%", x_pad + 120, y_pad + 72);
-
-  tft.unloadFont();
-
-  isWeatherPrinted = true;
+  CanvasDrawSmoothString((weather.humi >= 10 ? "" : " ") + String(weather.humi) + "%", x_pad + 120, y_pad + 72,
+                         weather.isCached ? STALE_COLOR : TextColorByHumidity(weather.humi));
 }
 
 // **Finance**
+// cached and not fetched since boot, cached currencies are current once the clock shows they are from today
+bool IsFinanceStale(const FinanceData &finance, uint8_t index)
+{
+  if (!finance.isCached[index])
+    return false;
+  return watchlist.Type(index) != WatchCurrency || !isClockSynced || currencyUpdateDate < DateNumber(timeinfo);
+}
+
 void TFTPrintFinanceInfo()
 {
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  if (financeIndex != financeIndexPrev)
-    tft.drawString("                                              ", x_pad, y_pad + 90, 2);
-  tft.drawString("                                              ", x_pad, y_pad + 110, 2);
+  TelemetrySpan span(telemetry, WidgetFinance);
+  FinanceData finance;
+  financeVersionPrinted = financeSnapshot.Read(finance);
 
-  tft.loadFont(Cubic12);
+  if (financeIndex != financeIndexPrev)
+  {
+    CanvasClearArea(x_pad, y_pad + 90, canvas.width() - x_pad, 16);
+    financeSparkline.Invalidate();
+  }
+  CanvasClearArea(x_pad, y_pad + 110, canvas.width() - x_pad, 16);
+  isFinancePrinted = true;
+  if (financeIndex >= watchlist.Count())
+  {
+    return;
+  }
 
-  // print name
+  // print name, with the stock type and number for ETFs and stocks
   if (financeIndex != financeIndexPrev)
   {
-    String type, number;
-    // if number is stock in etf or index, then print its stock type
-    if (financeNumbers[financeIndex].startsWith("se_"))
-    {
-      type = "ETF ";
-    }
-    else if (financeNumbers[financeIndex].startsWith("si_"))
-    {
-      type = "INDEX ";
-    }
-    // if number is stock in normal or etf, then print its stock number
-    if ((financeNumbers[financeIndex].startsWith("sn_") || financeNumbers[financeIndex].startsWith("se_")))
-    {
-      number = financeNumbers[financeIndex].substring(3);
-    }
-    tft.setTextColor(0xFFFF, TFT_BLACK);
-    tft.drawString(financeNames[financeIndex] + "  " + type + number, x_pad + 5, y_pad + 92);
+    WatchType type = watchlist.Type(financeIndex);
+    String name = watchlist.Name(financeIndex);
+    name += "  ";
+    name += watchlist.TypeLabel(financeIndex);
+    if (type == WatchEtf || type == WatchStock)
+      name += watchlist.Symbol(financeIndex);
+    CanvasDrawSmoothString(name, x_pad + 5, y_pad + 92, 0xFFFF);
     financeIndexPrev = financeIndex;
   }
 
+  // today's ticks of TWSE entries, drawn over the end of a long name
+  if (watchlist.Type(financeIndex) != WatchCurrency)
+    financeSparkline.Draw(intradayHistory, financeIndex);
+
+  // prices indexed by the list before an edit are not shown until the HTTP task caught up
+  bool isCurrent = finance.watchlistVersion == watchlistSnapshot.Version();
+  float price = isCurrent ? finance.prices[financeIndex] : 0;
+  float yesterdayPrice = isCurrent ? finance.yesterdayPrices[financeIndex] : 0;
+  unsigned int decimals = watchlist.Type(financeIndex) == WatchCurrency ? 4 : 2;
+  bool isStale = isCurrent && IsFinanceStale(finance, financeIndex);
+
   // print price
-  if (financePrices[financeIndex])
+  if (price)
   {
-    tft.setTextColor(0xFFFF, TFT_BLACK);
-    tft.drawString(String(financePrices[financeIndex], financeIndex < STOCK_COUNT ? 2 : 4), x_pad + 5, y_pad + 112);
+    CanvasDrawSmoothString(String(price, decimals), x_pad + 5, y_pad + 112, isStale ? STALE_COLOR : 0xFFFF);
   }
   else
   {
-    tft.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
-    tft.drawString("--", x_pad + 5, y_pad + 112);
+    CanvasDrawSmoothString("--", x_pad + 5, y_pad + 112, TFT_LIGHTGREY);
   }
 
   // print price change
-  if (financePrices[financeIndex] && financeYesterdayPrices[financeIndex])
+  if (price && yesterdayPrice)
   {
-    float changeAmount = financePrices[financeIndex] - financeYesterdayPrices[financeIndex];
-    float changePercent = (financePrices[financeIndex] / financeYesterdayPrices[financeIndex] - 1.0) * 100;
-    tft.setTextColor(TextColorByAmount(changeAmount), TFT_BLACK);
-    tft.drawString((changeAmount >= 0 ? "+" : "") + String(changeAmount, financeIndex < STOCK_COUNT ? 2 : 4) + "(" + String(abs(changePercent), changePercent >= 10 ? 1 : 2) + "%)",
-                   x_pad + 65, y_pad + 112);
+    float changeAmount = price - yesterdayPrice;
+    float changePercent = (price / yesterdayPrice - 1.0) * 100;
+    CanvasDrawSmoothString((changeAmount >= 0 ? "+" : "") + String(changeAmount, decimals) + "(" + String(abs(changePercent), changePercent >= 10 ? 1 : 2) + "%)",
+                           x_pad + 65, y_pad + 112, isStale ? STALE_COLOR : TextColorByAmount(changeAmount));
   }
   else
   {
-    tft.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
-    tft.drawString("--", x_pad + 65, y_pad + 112);
+    CanvasDrawSmoothString("--", x_pad + 65, y_pad + 112, TFT_LIGHTGREY);
   }
-
-  tft.unloadFont();
-
-  isFinancePrinted = true;
 }
 
 // **Player**
 void TFTPrintPlayerState()
 {
+  TelemetrySpan span(telemetry, WidgetPlayerState);
   // clear player state screen area
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  tft.drawString("           ", x_pad, 5, 2);
+  CanvasClearArea(x_pad, 5, 80, 16);
   switch (playerState)
   {
   case 0:
-    tft.setTextColor(0x07E0, TFT_BLACK);
-    tft.drawString("Playing >", x_pad, 5, 2);
+    canvas.setTextColor(0x07E0, TFT_BLACK);
+    canvas.drawString("Playing >", x_pad, 5, 2);
     break;
   case 1:
-    tft.setTextColor(0x001F, TFT_BLACK);
-    tft.drawString("Pause ||", x_pad, 5, 2);
+    canvas.setTextColor(0x001F, TFT_BLACK);
+    canvas.drawString("Pause ||", x_pad, 5, 2);
     break;
   case 2:
-    tft.setTextColor(0xF800, TFT_BLACK);
-    tft.drawString("Stop []", x_pad, 5, 2);
+    canvas.setTextColor(0xF800, TFT_BLACK);
+    canvas.drawString("Stop []", x_pad, 5, 2);
     break;
   }
 }
 
 void TFTPrintPlayerSongCodec()
 {
+  TelemetrySpan span(telemetry, WidgetCodec);
   // clear song codec screen area
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  tft.drawString("            ", x_pad + 85, 5, 2);
+  CanvasClearArea(x_pad + 85, 5, canvas.width() - (x_pad + 85), 16);
 
-  tft.setTextColor(0xFFFF, TextBackgroundColorByCodec(songCodec));
+  canvas.setTextColor(0xFFFF, TextBackgroundColorByCodec(songCodec));
   // print song codec
   int xposCodec = x_pad + 125;
-  tft.drawString(" " + songCodec + " ", xposCodec + (songCodec.length() * -5.2), 5, 2);
+  CanvasDrawString(" " + songCodec + " ", xposCodec + (songCodec.length() * -5.2), 5, 2);
 }
 
 void TFTPrintPlayerSongDuration()
 {
+  TelemetrySpan span(telemetry, WidgetDuration);
   // set color
-  tft.setTextColor(0xFFFF, TFT_BLACK);
+  canvas.setTextColor(0xFFFF, TFT_BLACK);
 
   // print duration in 00:00 format
-  tft.drawString(((songDuration / 60 < 10) ? "0" : "") + String(songDuration / 60) + ":" + ((songDuration % 60 < 10) ? "0" : "") + String(songDuration % 60),
-                 x_pad + 118, 27, 1);
+  CanvasDrawString(((songDuration / 60 < 10) ? "0" : "") + String(songDuration / 60) + ":" + ((songDuration % 60 < 10) ? "0" : "") + String(songDuration % 60),
+                   x_pad + 118, 27, 1);
 }
 
-void TFTPrintPlayerSongPosition()
+int16_t SongBarColumn(uint32_t positionMs)
 {
-  // set color
-  tft.setTextColor(0xFFFF, TFT_BLACK);
+  if (songDuration <= 0)
+  {
+    return 0;
+  }
+  return constrain((int64_t)positionMs * (SONG_BAR_WIDTH - 1) / (songDuration * 1000LL), 0LL, SONG_BAR_WIDTH - 1LL);
+}
+
+// redraw columns [from, to] of the position bar: track, played part and knob
+void TFTDrawSongBarSpan(int16_t from, int16_t to, int16_t column)
+{
+  canvas.fillRect(x_pad + from, 37, to - from + 1, 8, TFT_BLACK);
+  canvas.drawFastHLine(x_pad + from, 40, to - from + 1, 0x39C4);
+  if (column >= from)
+  {
+    canvas.fillRect(x_pad + from, 40, min(column, to) - from + 1, 2, 0xFFFF);
+  }
+  // 3 px knob, clipped to the span so nothing is left outside the dirty rect at the bar ends
+  int16_t knobLeft = max<int16_t>(column - 1, from);
+  int16_t knobRight = min<int16_t>(column + 1, to);
+  if (knobLeft <= knobRight)
+  {
+    canvas.fillRect(x_pad + knobLeft, 38, knobRight - knobLeft + 1, 6, 0xFFFF);
+  }
+  compositor.MarkDirty(x_pad + from, 37, to - from + 1, 8);
+}
 
-  // print position in 00:00 format
-  tft.drawString(((songPostion / 60) < 10 ? "0" : "") + String(songPostion / 60) + ":" + ((songPostion % 60) < 10 ? "0" : "") + String(songPostion % 60),
-                 x_pad, 27, 1);
+// called every loop, draws only when the second or the bar pixel column changed
+void TFTPrintPlayerSongPosition()
+{
+  TelemetrySpan span(telemetry, WidgetPosition);
+  uint32_t positionMs = songPositionClock.PositionMs();
+  int32_t positionSec = positionMs / 1000;
+  if (positionSec != songPositionSecPrinted)
+  {
+    // print position in 00:00 format
+    canvas.setTextColor(0xFFFF, TFT_BLACK);
+    CanvasDrawString(((positionSec / 60) < 10 ? "0" : "") + String(positionSec / 60) + ":" + ((positionSec % 60) < 10 ? "0" : "") + String(positionSec % 60),
+                     x_pad, 27, 1);
+    songPositionSecPrinted = positionSec;
+  }
 
-  // draw position bar
-  int xposSong = x_pad;
-  int xIndexPlayingPosition = map(((float)songPostion / (float)songDuration) * 100, 0, 100, 0, 24);
-  for (int i = 0; i <= 24; i++)
+  // draw position bar, only the span between old and new knob when it moved
+  int16_t column = SongBarColumn(positionMs);
+  if (column == songBarColumnPrev)
+  {
+    return;
+  }
+  if (songBarColumnPrev < 0)
+  {
+    TFTDrawSongBarSpan(0, SONG_BAR_WIDTH - 1, column);
+  }
+  else
   {
-    xposSong += tft.drawString(i == xIndexPlayingPosition ? "+" : "-", xposSong, 37, 1);
+    TFTDrawSongBarSpan(max(0, min(column, songBarColumnPrev) - 1), min(SONG_BAR_WIDTH - 1, max(column, songBarColumnPrev) + 1), column);
   }
+  songBarColumnPrev = column;
 }
 
 void TFTPrintPlayerSongGeneralInfo()
 {
+  TelemetrySpan span(telemetry, WidgetGeneralInfo);
   // clear song general info screen area
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  tft.drawString("                             ", 0, 49, 1);
+  CanvasClearArea(0, 49, canvas.width(), canvas.fontHeight(1));
 
   // print song general info
-  tft.drawString(songBitDepth + "bits " + songSampleRate + "Hz " + songBitrate + "kbps",
-                 x_pad, 49, 1);
+  canvas.setTextColor(0xFFFF, TFT_BLACK);
+  canvas.drawString(songBitDepth + "bits " + songSampleRate + "Hz " + songBitrate + "kbps",
+                    x_pad, 49, 1);
 }
 
 void TFTPrintPlayerSongMetadata(String value, int lineIndex)
 {
+  TelemetrySpan span(telemetry, WidgetMetadata);
   // clear screen
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  tft.drawString("                             ", 0, y_pad + songMetadataYPosOffset - 2 + lineIndex * 17, 2);
-
-  // load han character
-  tft.loadFont(Cubic12);
+  CanvasClearArea(0, y_pad + songMetadataYPosOffset - 2 + lineIndex * 17, ALBUM_ART_X - 4, 16);
 
   // print artist/album/title name
-  tft.setTextColor(0xFFFF);
-  tft.drawString(value, x_pad, y_pad + songMetadataYPosOffset + lineIndex * 17);
+  if (!CanvasStartMarquee(*songMetadataMarquees[lineIndex], value.c_str(), value.length()))
+    CanvasDrawSmoothString(value, x_pad, y_pad + songMetadataYPosOffset + lineIndex * 17, 0xFFFF);
+}
 
-  // unload han character
-  tft.unloadFont();
+void TFTPrintPlayerAlbumArt()
+{
+  TFT_eSprite *art = albumArt.Current();
+  if (art != nullptr)
+  {
+    compositor.Blit(*art, ALBUM_ART_X, ALBUM_ART_Y);
+    return;
+  }
+  // no art for this track, or not here yet
+  CanvasClearArea(ALBUM_ART_X, ALBUM_ART_Y, ALBUM_ART_SIZE, ALBUM_ART_SIZE);
+  canvas.drawRect(ALBUM_ART_X, ALBUM_ART_Y, ALBUM_ART_SIZE, ALBUM_ART_SIZE, TFT_DARKGREY);
 }
 
 void TFTPrintPlayerSongCurrentLyric()
 {
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  tft.drawString("                           ", x_pad, 114, 2);
-
-  // load han character
-  tft.loadFont(Cubic12);
+  TelemetrySpan span(telemetry, WidgetLyric);
+  CanvasClearArea(x_pad, 114, canvas.width() - x_pad, 16);
 
   // print lyric
-  tft.setTextColor(0xFFFF, TFT_BLACK);
-  tft.drawString(songCurrentLyric, x_pad, 116);
+  if (!CanvasStartMarquee(lyricMarquee, songCurrentLyric.c_str(), songCurrentLyric.length()))
+    CanvasDrawSmoothString(songCurrentLyric, x_pad, 116, 0xFFFF);
+}
 
-  // unload han character
-  tft.unloadFont();
+// duration/position are decimal seconds in text frames, u32 milliseconds in binary frames
+float PlayerFrameSeconds(const PlayerLinkFrame &frame)
+{
+  if (frame.type == LinkU32)
+  {
+    return PlayerLinkU32(frame) / 1000.0;
+  }
+  return SliceToFloat(frame.payload);
 }
 
-void PlayerInfoUIUpdate(PlayerInfoId infoId, String value)
+// render lyric line into the look-ahead sprite, laid out like TFTPrintPlayerSongCurrentLyric
+void TFTPrerenderPlayerLyric(int16_t index)
 {
+  const char *line = lyricTimeline.Line(index);
+  lyricNextSprite.fillSprite(TFT_BLACK);
+  glyphCache.DrawString(lyricNextSprite, line, strlen(line), 0, 2, 0xFFFF, TFT_BLACK);
+  lyricPrerenderedIndex = index;
+}
+
+void TFTPrintPlayerTimelineLyric()
+{
+  int16_t index = lyricTimeline.Find(songPositionClock.PositionMs());
+  if (index == lyricIndexPrev)
+  {
+    return;
+  }
+  TelemetrySpan span(telemetry, WidgetLyricTimeline);
+
+  if (!lyricNextSprite.created())
+  {
+    songCurrentLyric = lyricTimeline.Line(index);
+    TFTPrintPlayerSongCurrentLyric();
+    lyricIndexPrev = index;
+    return;
+  }
+
+  // normally the line was rendered when the previous one went up, only a seek renders here
+  const char *line = lyricTimeline.Line(index);
+  if (!CanvasStartMarquee(lyricMarquee, line, strlen(line)))
+  {
+    if (index != lyricPrerenderedIndex)
+      TFTPrerenderPlayerLyric(index);
+    compositor.Blit(lyricNextSprite, x_pad, 114);
+  }
+  lyricIndexPrev = index;
+
+  TFTPrerenderPlayerLyric(index + 1);
+}
+
+// ms until the player screen changes on its own: position second, bar column or next lyric line
+uint32_t PlayerNextChangeMs()
+{
+  if (playerState != Playing)
+  {
+    return RENDER_WAIT_FOREVER;
+  }
+
+  uint32_t positionMs = songPositionClock.PositionMs();
+  uint32_t waitMs = 1000 - positionMs % 1000;
+  if (songDuration > 0)
+  {
+    // first ms of the next bar column
+    int16_t column = SongBarColumn(positionMs);
+    uint32_t columnMs = ((column + 1) * (songDuration * 1000ULL) + SONG_BAR_WIDTH - 2) / (SONG_BAR_WIDTH - 1);
+    if (columnMs > positionMs)
+      waitMs = min(waitMs, columnMs - positionMs);
+  }
+  if (lyricTimeline.Count())
+  {
+    int16_t index = lyricTimeline.Find(positionMs);
+    if (index + 1 < lyricTimeline.Count())
+      waitMs = min(waitMs, lyricTimeline.LineMs(index + 1) - positionMs);
+  }
+  return waitMs;
+}
+
+void PlayerInfoUIUpdate(PlayerInfoId infoId, const PlayerLinkFrame &frame)
+{
+  const SerialSlice &value = frame.payload;
   switch (infoId)
   {
   case Artist:
-    songArtist = value;
+    SliceAssign(songArtist, value);
     TFTPrintPlayerSongMetadata(songArtist, 0);
     break;
   case Album:
-    songAlbum = value;
+    SliceAssign(songAlbum, value);
     TFTPrintPlayerSongMetadata(songAlbum, 1);
     break;
   case Title:
-    songTitle = value;
+    SliceAssign(songTitle, value);
     TFTPrintPlayerSongMetadata(songTitle, 2);
     break;
   case BitDepth:
-    songBitDepth = value;
+    SliceAssign(songBitDepth, value);
     TFTPrintPlayerSongGeneralInfo();
     break;
   case Bitrate:
-    songBitrate = value;
+    SliceAssign(songBitrate, value);
     TFTPrintPlayerSongGeneralInfo();
     break;
   case SampleRate:
-    songSampleRate = value;
+    SliceAssign(songSampleRate, value);
     TFTPrintPlayerSongGeneralInfo();
     break;
   case Codec:
-    songCodec = value;
+    SliceAssign(songCodec, value);
     TFTPrintPlayerSongCodec();
     break;
   case Duration:
-    songDuration = value.toFloat();
+    songDuration = PlayerFrameSeconds(frame);
+    songBarColumnPrev = -1;
     TFTPrintPlayerSongDuration();
+    TFTPrintPlayerSongPosition();
     break;
   case Position:
-    songPostion = value.toFloat();
+    songPositionClock.Sync(PlayerFrameSeconds(frame) * 1000);
     TFTPrintPlayerSongPosition();
     break;
   case PlaybackState:
-    switch (value[1])
+    switch (value.length > 1 ? value.data[1] : '\0')
     {
     case 'l':
       playerState = Playing;
@@ -698,25 +1197,83 @@ void PlayerInfoUIUpdate(PlayerInfoId infoId, String value)
       playerState = Stopped;
       break;
     }
+    // freeze or restart the local position clock at the state change
+    songPositionClock.SetPlaying(playerState == Playing);
     TFTPrintPlayerState();
     break;
   case LyricCurrent:
-    songCurrentLyric = value;
+    SliceAssign(songCurrentLyric, value);
+    // lyric timeline takes over when the host uploaded one
+    if (lyricTimeline.Count() == 0)
+      TFTPrintPlayerSongCurrentLyric();
+    break;
+  case LyricClear:
+    lyricTimeline.Clear();
+    lyricIndexPrev = -2;
+    lyricPrerenderedIndex = -2;
+    songCurrentLyric = "";
     TFTPrintPlayerSongCurrentLyric();
     break;
+  case LyricLine:
+    if (lyricTimeline.AddLrcLine(value.data, value.length))
+    {
+      // indexes may have shifted, look the line up again
+      lyricIndexPrev = -2;
+      lyricPrerenderedIndex = -2;
+    }
+    break;
+  case AlbumArtData:
+    if (albumArt.Handle(frame))
+      TFTPrintPlayerAlbumArt();
+    break;
   default:
     break;
   }
 }
 
 // **UI Update**
+// one tick per minute of the TWSE session for every stock, whatever screen is shown
+void RecordIntradayTicks()
+{
+  FinanceData finance;
+  financeVersionRecorded = financeSnapshot.Read(finance);
+  int16_t minute = (timeinfo.tm_hour - 9) * 60 + timeinfo.tm_min;
+  bool isTradingDay = timeinfo.tm_wday > 0 && timeinfo.tm_wday < 6;
+  if (!isClockSynced || !isTradingDay || minute < 0 || minute >= INTRADAY_SESSION_MINUTES || finance.watchlistVersion != watchlistSnapshot.Version())
+  {
+    return;
+  }
+
+  for (uint8_t i = 0; i < watchlist.StockCount(); i++)
+  {
+    if (finance.prices[i] != 0 && !finance.isCached[i])
+      intradayHistory.Record(i, minute, finance.prices[i], finance.yesterdayPrices[i]);
+  }
+}
+
+// redraw only when the HTTP task published something new
+void ScreenUIUpdateMainData()
+{
+  if (weatherSnapshot.Version() != weatherVersionPrinted)
+    TFTPrintOpenWeatherInfo();
+
+  if (!isFinancePrinted || financeSnapshot.Version() != financeVersionPrinted)
+    TFTPrintFinanceInfo();
+}
+
 void ScreenUIUpdateMain()
 {
+  // nothing runs by the clock before NTP set it, cached weather and prices are drawn meanwhile
+  if (!isClockSynced)
+  {
+    ScreenUIUpdateMainData();
+    return;
+  }
+
   // update by day
   if (timeinfo.tm_mday != dayPrev)
   {
     TFTPrintDate();
-    isWorkingDay = (timeinfo.tm_wday > 0 && timeinfo.tm_wday < 6);
 
     dayPrev = timeinfo.tm_mday;
   }
@@ -724,28 +1281,16 @@ void ScreenUIUpdateMain()
   // update by hour
   if (timeinfo.tm_hour != hourPrev)
   {
-    // update weather
-    httpGetReq.type = Weather;
-    httpGetReq.index = 0;
-    xQueueSend(queueHttpGet, &httpGetReq, 100);
+    // update weather, unless setup just asked for it
+    if (!isWeatherRequestedAtBoot)
+      RequestHttpGet(Weather, 0);
+    isWeatherRequestedAtBoot = false;
 
     // update currency
     if (timeinfo.tm_hour == 8)
     {
-      httpGetReq.type = Currency;
-      httpGetReq.index = 0;
-      xQueueSend(queueHttpGet, &httpGetReq, 100);
-    }
-
-    // update TWSE Opening state
-    bool isTWSEOpeningPrev = isWorkingDay && (timeinfo.tm_hour >= 9 && timeinfo.tm_hour <= 13);
-    if (isTWSEOpening != isTWSEOpeningPrev)
-    {
-      httpGetReq.type = TWSE;
-      httpGetReq.index = 255;
-      xQueueSend(queueHttpGet, &httpGetReq, 100);
+      RequestHttpGet(Currency, 0);
     }
-    isTWSEOpening = isTWSEOpeningPrev;
 
     hourPrev = timeinfo.tm_hour;
   }
@@ -766,49 +1311,73 @@ void ScreenUIUpdateMain()
     TFTPrintSecBlink();
     TFTPrintTimeSec();
 
-    if (isTWSEOpening && timeinfo.tm_hour <= 13 && timeinfo.tm_min <= 31)
+    // next finance item every 30 sec during the TWSE session, every 60 sec otherwise, the HTTP task keeps prices fresh
+    bool isTwseSession = QuotePoller::Phase(timeinfo) != TwseClosed;
+    if (isTwseSession ? timeinfo.tm_sec % 30 == 0 : timeinfo.tm_sec == 0)
     {
-      if (timeinfo.tm_sec % 30 == 0) // change to next finance item index every 30 sec
-      {
-        IncreaseFinanceIndex();
-        // when current index is currency, only print it out
-        if (financeIndex >= STOCK_COUNT)
-          isFinancePrinted = false;
-      }
-      // when current index is TWSE(stock), update value every 5 sec
-      if (financeIndex < STOCK_COUNT && timeinfo.tm_sec % 5 == 0)
-      {
-        httpGetReq.type = TWSE;
-        httpGetReq.index = financeIndex;
-        xQueueSend(queueHttpGet, &httpGetReq, 100);
-      }
-    }
-    else
-    {
-      // when not in TWSE opening time, print finance every 60 sec
-      if (timeinfo.tm_sec == 0)
-      {
-        IncreaseFinanceIndex();
-        isFinancePrinted = false;
-      }
+      IncreaseFinanceIndex();
+      isFinancePrinted = false;
     }
 
     // update previous state
     secPrev = timeinfo.tm_sec;
   }
 
-  if (!isWeatherPrinted)
-    TFTPrintOpenWeatherInfo();
+  ScreenUIUpdateMainData();
+}
 
-  if (!isFinancePrinted)
-    TFTPrintFinanceInfo();
+// list or edit the watchlist, edits are saved and handed to the HTTP task at once
+void WatchlistCommand(const PlayerLinkFrame &frame)
+{
+  bool isChanged = false;
+  switch (frame.field)
+  {
+  case WATCHLIST_FIELD_LIST:
+    for (uint8_t i = 0; i < watchlist.Count(); i++)
+    {
+      linkLog.printf("[WATCH] %u %s%s %s\n", i, watchlist.TypeLabel(i), watchlist.Symbol(i), watchlist.Name(i));
+    }
+    linkLog.printf("[WATCH] %u/%u symbols, %u/%u name bytes\n", watchlist.Count(), WATCHLIST_MAX_SYMBOLS,
+                  watchlist.PoolUsed(), WATCHLIST_POOL_SIZE);
+    return;
+  case WATCHLIST_FIELD_ADD:
+    isChanged = watchlist.Add(frame.payload.data, frame.payload.length);
+    break;
+  case WATCHLIST_FIELD_REMOVE:
+    isChanged = watchlist.Remove(frame.payload.data, frame.payload.length);
+    break;
+  case WATCHLIST_FIELD_RESET:
+    watchlist.Reset();
+    isChanged = true;
+    break;
+  }
+  linkLog.println(isChanged ? "[WATCH] ok" : "[WATCH] rejected");
+  if (!isChanged)
+  {
+    return;
+  }
+
+  preferences.begin("storage");
+  watchlist.Save(preferences, "watchlist");
+  preferences.end();
+  watchlistSnapshot.Publish(watchlist);
+
+  // restart the rotation and fetch prices for the new list
+  intradayHistory.Reset();
+  financeIndex = 0;
+  financeIndexPrev = 255;
+  isFinancePrinted = false;
+  RequestHttpGet(TWSE, HTTP_JOB_ALL);
+  if (frame.field == WATCHLIST_FIELD_ADD && strncmp(frame.payload.data, "cu_", 3) == 0)
+  {
+    RequestHttpGet(Currency, 0);
+    RequestHttpGet(Currency, 1);
+  }
 }
 
-void ScreenUIUpdatePlayer(String msg)
+void ScreenUIUpdatePlayer(const PlayerLinkFrame &frame)
 {
-  PlayerInfoId playerInfoId = (PlayerInfoId)(msg.substring(msg.indexOf('$') + 1, msg.lastIndexOf('$')).toInt());
-  String value = msg.substring(msg.lastIndexOf('$') + 1);
-  PlayerInfoUIUpdate(playerInfoId, value);
+  PlayerInfoUIUpdate((PlayerInfoId)frame.field, frame);
 }
 
 void ChangeScreenState(ScreenState targetScreenState)
@@ -822,7 +1391,8 @@ void ChangeScreenState(ScreenState targetScreenState)
   screenState = targetScreenState;
 
   // force clear screen and previous states when screenState changed
-  ClearScreen(0, 160, 5);
+  ClearScreen();
+  playerMarquees.StopAll();
 
   // print first screen
   switch (screenState)
@@ -833,124 +1403,422 @@ void ChangeScreenState(ScreenState targetScreenState)
     hourPrev = 255;
     minPrev = 255;
     secPrev = 255;
+    memset(clockDigitsShown, 255, sizeof(clockDigitsShown));
     financeIndex = 0;
     financeIndexPrev = 255;
     isFinancePrinted = false;
-    tft.setTextColor(TFT_DARKGREY);
-    tft.drawString("LOADING", x_pad + 5, y_pad + 73, 1);
-    tft.drawString("LOADING", x_pad + 5, y_pad + 93, 1);
+    weatherVersionPrinted = 0; // redraw cached weather, if any
+    canvas.setTextColor(TFT_DARKGREY);
+    if (!isClockSynced)
+      canvas.drawString("SYNCING CLOCK", x_pad + 5, y_pad, 1); // the date is drawn over it
+    canvas.drawString("LOADING", x_pad + 5, y_pad + 73, 1);
+    canvas.drawString("LOADING", x_pad + 5, y_pad + 93, 1);
   }
   break;
   case PlayerScreen:
   {
+    lyricIndexPrev = -2;
+    songPositionSecPrinted = -1;
+    songBarColumnPrev = -1;
     TFTPrintPlayerState();
     TFTPrintPlayerSongDuration();
     TFTPrintPlayerSongPosition();
     TFTPrintPlayerSongGeneralInfo();
+    TFTPrintPlayerAlbumArt();
   }
   break;
+  case SpectrumScreen:
+    spectrum.Invalidate();
+    break;
   }
 }
 
+// **Stats**
+unsigned long statsPrintedMillis = 0;
+void PrintStats()
+{
+  String bootPhases;
+  for (uint8_t i = 0; i < bootLog.PhaseCount(); i++)
+  {
+    bootPhases += i ? " / " : "";
+    bootPhases += bootLog.Name(i);
+    bootPhases += " ";
+    bootPhases += bootLog.IsMarked(i) ? String(bootLog.At(i)) : String("-");
+  }
+  linkLog.printf("[STATS] Boot %s ms, %u over budget\n", bootPhases.c_str(), bootLog.OverBudget());
+
+  const CompositorStats &tftStats = compositor.Stats();
+  linkLog.printf("[STATS] TFT %u B/s, total %u B, %u rects in %u flushes, %.1f fps, DMA wait %.2f%% (%u us total)\n",
+                tftStats.bytesPushedPerSec, tftStats.bytesPushedTotal, tftStats.rectsPushedTotal, tftStats.flushCount,
+                tftStats.framesPerSec, tftStats.dmaWaitPercent, tftStats.dmaWaitMicrosTotal);
+
+  const GlyphCacheStats &glyphStats = glyphCache.Stats();
+  linkLog.printf("[STATS] Glyph %u hit / %u miss / %u evict, %u strings avg %u us\n",
+                glyphStats.hits, glyphStats.misses, glyphStats.evictions, glyphStats.strings,
+                glyphStats.strings ? glyphStats.renderMicros / glyphStats.strings : 0);
+  const DigitAtlasStats &atlasStats = clockAtlas.Stats();
+  linkLog.printf("[STATS] Digit atlas %u blits, %u rasterized\n", atlasStats.blits, atlasStats.fallbackDraws);
+
+  const SerialRxStats &rxStats = serialRx.Stats();
+  linkLog.printf("[STATS] Serial %u B, %u frames, %u overrun B, %u UART errors, %u dropped frames\n",
+                rxStats.bytes, rxStats.frames, rxStats.overrunBytes, rxStats.uartErrors, rxStats.droppedFrames);
+
+  const PlayerLinkStats &linkStats = playerLink.Stats();
+  linkLog.printf("[STATS] Link %s, %u text / %u binary frames, %u crc err, %u bad len, %u resync B\n",
+                playerLink.Mode() == LinkModeBinary ? "binary" : "text", linkStats.textFrames, linkStats.binaryFrames,
+                linkStats.crcErrors, linkStats.badLengths, linkStats.resyncBytes);
+
+  const PositionClockStats &clockStats = songPositionClock.Stats();
+  linkLog.printf("[STATS] Position %u syncs, %u snaps, err last %d / mean %u / max %u ms, drift %d ppm\n",
+                clockStats.syncs, clockStats.snaps, clockStats.lastErrorMs, clockStats.meanAbsErrorMs,
+                clockStats.maxAbsErrorMs, clockStats.driftPpm);
+
+  linkLog.printf("[STATS] HTTP peak heap weather %u B, twse %u B, currency %u B\n",
+                httpPeakHeap[Weather], httpPeakHeap[TWSE], httpPeakHeap[Currency]);
+  HttpSchedulerStats jobStats = httpScheduler.Stats();
+  linkLog.printf("[STATS] HTTP jobs %u submitted, %u coalesced, %u dropped, queued avg %u / max %u ms\n",
+                jobStats.submitted, jobStats.coalesced, jobStats.droppedFull,
+                jobStats.served ? jobStats.queuedMsTotal / jobStats.served : 0, jobStats.queuedMsMax);
+  MarketCacheStats cacheStats;
+  marketCacheStatsSnapshot.Read(cacheStats);
+  linkLog.printf("[STATS] NVS cache %u writes (%u since boot, %u B), %u changes merged, worn out in %.0f years at this rate\n",
+                cacheStats.lifetimeWrites, cacheStats.writes, cacheStats.bytesWritten, cacheStats.merged,
+                MarketCache::WearYears(cacheStats));
+  for (uint8_t i = 0; i < httpPool.HostCount(); i++)
+  {
+    const HttpHostStats &hostStats = httpPool.Stats(i);
+    linkLog.printf("[STATS] HTTP %s %u req, %u failed, %u handshakes, p50 %u / p90 %u / p99 %u / max %u ms\n",
+                  httpPool.HostName(i), hostStats.requests, hostStats.failures, hostStats.handshakes,
+                  HttpLatencyPercentile(hostStats, 50), HttpLatencyPercentile(hostStats, 90),
+                  HttpLatencyPercentile(hostStats, 99), hostStats.maxLatencyMs);
+  }
+
+  const RenderSchedulerStats &renderStats = renderScheduler.Stats();
+  linkLog.printf("[STATS] Render %.1f wakeups/s, busy %.1f%%, %u ticks / %u serial / %u http / %u timeouts\n",
+                renderStats.wakeupsPerSec, renderStats.busyPercent, renderStats.ticks, renderStats.serialEvents,
+                renderStats.httpEvents, renderStats.timeouts);
+
+  const QuotePollerStats &pollStats = quotePoller.Stats();
+  linkLog.printf("[STATS] TWSE session %u: %u requests, %u symbols polled, %u new trades, quote age avg %.1f / max %.1f s\n",
+                pollStats.date, pollStats.requests, pollStats.symbolsPolled, pollStats.trades,
+                quotePoller.AverageAgeSec(), pollStats.ageMsMax / 1000.0);
+
+  const SparklineStats &sparklineStats = financeSparkline.Stats();
+  linkLog.printf("[STATS] Sparkline %u full draws, %u shifts, %u columns drawn\n",
+                sparklineStats.fullDraws, sparklineStats.shifts, sparklineStats.columnsDrawn);
+
+  const MarqueeStats &marqueeStats = playerMarquees.Stats();
+  linkLog.printf("[STATS] Marquee %u frames, %u steps, %u deferred over budget, busiest frame %u us, strip %u B (peak %u B)\n",
+                marqueeStats.frames, marqueeStats.steps, marqueeStats.deferred, marqueeStats.busyMicrosMax,
+                marqueeStrip.Bytes(), marqueeStrip.BytesPeak());
+
+  const AlbumArtStats &artStats = albumArt.Stats();
+  linkLog.printf("[STATS] Album art %u images, %u cache hits, %u rejected, %u out of sequence, %u aborted, %u B total, last %u B in %u ms, expanded in %u us\n",
+                artStats.images, artStats.cacheHits, artStats.rejected, artStats.outOfSequence, artStats.aborted,
+                artStats.bytesTotal, artStats.lastBytes, artStats.lastTransferMs, artStats.lastDecodeMicros);
+
+  const SpectrumStats &spectrumStats = spectrum.Stats();
+  linkLog.printf("[STATS] Spectrum %u frames, %u dropped, %u merged, %u bad, %u drawn, %u rows, latency avg %u / max %u us\n",
+                spectrumStats.frames, spectrumStats.dropped, spectrumStats.merged, spectrumStats.badFrames,
+                spectrumStats.drawnFrames, spectrumStats.rowsDrawn, spectrum.AverageLatencyMicros(), spectrumStats.latencyMicrosMax);
+
+  linkLog.printf("[STATS] Lyric timeline %u lines, %u dropped\n", lyricTimeline.Count(), lyricTimeline.DroppedLines());
+}
+
+#ifdef RENDER_BENCH
+// time each print routine over representative inputs, before wifi so nothing else draws or runs
+bool RunRenderBench()
+{
+  RenderBench bench(compositor);
+  const char *metadata[] = {
+      "Daft Punk",
+      "Random Access Memories",
+      "周杰倫 - 晴天",
+      "宇多田ヒカル / First Love (2022 Remastered)",
+      "夜に駆ける (YOASOBI) 沈むように溶けてゆくように 二人だけの空が広がる夜に",
+  };
+  const char *lyrics[] = {
+      "",
+      "故事的小黃花 從出生那年就飄著",
+      "刮風這天 我試過握著你手 但偏偏 雨漸漸 大到我看你不見 還要多久",
+  };
+
+  ClearScreen();
+
+  int8_t timeCase = bench.Add("TFTPrintTime", RENDER_BENCH_BUDGET_US);
+  const uint8_t hours[] = {0, 9, 12, 23};
+  const uint8_t minutes[] = {0, 5, 34, 59};
+  for (uint8_t hour : hours)
+  {
+    for (uint8_t minute : minutes)
+    {
+      timeinfo.tm_hour = hour;
+      timeinfo.tm_min = minute;
+      bench.Run(timeCase, TFTPrintTime);
+    }
+  }
+
+  // every index once as it appears (name + price) and once more as a price update
+  int8_t financeCase = bench.Add("TFTPrintFinanceInfo", RENDER_BENCH_BUDGET_US);
+  const float prices[] = {22886.45F, 196.35F, 1085.00F, 0.2093F, 32.8150F};
+  const float yesterdayPrices[] = {23011.12F, 195.10F, 1090.00F, 0.2101F, 32.7410F};
+  FinanceData finance = {};
+  finance.watchlistVersion = watchlistSnapshot.Version();
+  for (uint8_t i = 0; i < watchlist.Count(); i++)
+  {
+    finance.prices[i] = prices[i % 5];
+    finance.yesterdayPrices[i] = yesterdayPrices[i % 5];
+  }
+  financeSnapshot.Publish(finance);
+  for (financeIndex = 0; financeIndex < watchlist.Count(); financeIndex++)
+  {
+    bench.Run(financeCase, TFTPrintFinanceInfo);
+    bench.Run(financeCase, TFTPrintFinanceInfo);
+  }
+
+  // full bar redraw, then the knob moving one column and a seek across the bar
+  int8_t positionCase = bench.Add("TFTPrintPlayerSongPosition", RENDER_BENCH_BUDGET_US);
+  songDuration = 300;
+  const uint32_t positionsMs[] = {0, 2100, 4200, 150000, 299000};
+  songBarColumnPrev = -1;
+  songPositionSecPrinted = -1;
+  for (uint32_t positionMs : positionsMs)
+  {
+    songPositionClock.Sync(positionMs);
+    bench.Run(positionCase, TFTPrintPlayerSongPosition);
+  }
+
+  int8_t metadataCase = bench.Add("TFTPrintPlayerSongMetadata", RENDER_BENCH_BUDGET_US);
+  for (const char *value : metadata)
+  {
+    for (int lineIndex = 0; lineIndex < 3; lineIndex++)
+    {
+      bench.Run(metadataCase, [value, lineIndex]()
+                { TFTPrintPlayerSongMetadata(value, lineIndex); });
+    }
+  }
+
+  int8_t lyricCase = bench.Add("TFTPrintPlayerSongCurrentLyric", RENDER_BENCH_BUDGET_US);
+  for (const char *lyric : lyrics)
+  {
+    songCurrentLyric = lyric;
+    bench.Run(lyricCase, TFTPrintPlayerSongCurrentLyric);
+  }
+
+  bool isPassed = bench.Report();
+
+  // leave the state as if the bench never ran
+  timeinfo = {};
+  financeIndex = 0;
+  financeIndexPrev = 255;
+  financeSnapshot.Publish(financeLatest);
+  songDuration = 0;
+  songPositionClock = PositionClock();
+  songBarColumnPrev = -1;
+  songPositionSecPrinted = -1;
+  songCurrentLyric = "";
+  playerMarquees.StopAll();
+  ClearScreen();
+  compositor.Flush();
+  return isPassed;
+}
+#endif
+
 void setup()
 {
-  Serial.begin(115200);
+  Serial.setRxBufferSize(1024);
+  Serial.begin(SERIAL_BAUD_RATE);
+  serialRx.Begin(Serial);
+  serialRx.OnData([]()
+                  { renderScheduler.Notify(RENDER_EVENT_SERIAL); });
+  playerLink.Begin(serialRx, Serial);
+  linkLog.Begin(Serial, playerLink, TELEMETRY_SCREEN, TELEMETRY_FIELD_LOG);
+  telemetry.Begin(Serial, linkLog, widgetNames, WidgetCount);
+  bootLog.Begin(linkLog, bootPhaseNames, BootPhaseCount);
+  bootLog.SetBudget(BootFirstFrame, BOOT_FIRST_FRAME_BUDGET_MS);
+  quotePoller.Begin(linkLog);
+  telemetry.WatchTask(xTaskGetCurrentTaskHandle());
+  telemetry.WatchHttp(httpTypeStats, httpTypeNames, 3);
 
   tft.init();
   tft.setRotation(-1);
   tft.fillScreen(TFT_BLACK);
 
-  ClearScreen(0, 160, 5);
+  // allocate framebuffer before wifi/http fragment the heap
+  if (!compositor.Begin(TFT_BLACK))
+  {
+    Serial.println("Framebuffer allocation failed.");
+  }
 
-  tft.setTextColor(TFT_YELLOW, TFT_BLACK); // Note: the new fonts do not draw the background colour
-  tft.setCursor(0, 5);
+  lyricNextSprite.setColorDepth(16);
+  lyricNextSprite.createSprite(canvas.width() - x_pad, 16);
+  playerMarquees.Add(artistMarquee);
+  playerMarquees.Add(albumMarquee);
+  playerMarquees.Add(titleMarquee);
+  playerMarquees.Add(lyricMarquee);
+  spectrum.Begin(Serial);
+  if (!albumArt.Begin(Serial, linkLog))
+  {
+    Serial.println("Album art allocation failed.");
+  }
 
-  // connect to wifi
-  tft.print("[Wi-Fi] " + String(ssid));
-  WiFi.begin(ssid, password);
-  while (WiFi.status() != WL_CONNECTED)
+  // load han character once, glyphs are cached from here on
+  if (!glyphCache.Begin(Cubic12))
   {
-    delay(500);
-    tft.print(".");
+    Serial.println("Glyph cache allocation failed.");
+  }
+  // clock digits rendered once, the clock only blits them from here on
+  if (!clockAtlas.Begin(7, 0xFFFF, 0x39C4, TFT_BLACK))
+  {
+    Serial.println("Digit atlas allocation failed.");
   }
-  tft.println("ok");
-  delay(1000);
 
-  // setup ntp server
-  tft.print("[NTP] Setup...");
-  configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-  getLocalTime(&timeinfo);
-  tft.println("ok");
-  delay(1000);
+  bootLog.Mark(BootDisplay);
 
-  // setup currency data from preferences
-  tft.print("[PREF] Setup currency...");
+  // watchlist from NVS, the built-in one on first boot
+  if (!preferences.begin("storage", true) || !watchlist.Load(preferences, "watchlist"))
+  {
+    watchlist.Reset();
+  }
+  preferences.end();
+  watchlistSnapshot.Publish(watchlist);
+  httpWatchlist = watchlist;
+  financeLatest.watchlistVersion = watchlistSnapshot.Version();
+
+#if defined(RENDER_BENCH) && defined(NATIVE_BUILD)
+  exit(RunRenderBench() ? 0 : 1); // bench only run, the exit code is the result
+#elif defined(RENDER_BENCH)
+  RunRenderBench(); // report on serial, then boot as usual
+#endif
+
+  // last known prices and weather from preferences, drawn greyed out until the first HTTP answers
   if (preferences.begin("storage", true))
   {
-    for (uint8_t i = STOCK_COUNT; i < FINANCE_TOTAL_COUNT; i++)
-    {
-      financePrices[i] = preferences.getFloat(("c_" + String(i)).c_str(), 0.0F);
-      financeYesterdayPrices[i] = preferences.getFloat(("c_y_" + String(i)).c_str(), 0.0F);
-    }
-    currencyUpdateDate = preferences.getUInt("c_date", 0U);
+    marketCache.Load(preferences, "market");
+    marketCache.LoadLegacy(preferences, httpWatchlist); // keys of older firmware, gone after the first commit
     preferences.end();
   }
-  tft.println("ok");
-  delay(1000);
+  marketCacheStatsSnapshot.Publish(marketCache.Stats());
+  for (uint8_t i = 0; i < httpWatchlist.Count(); i++)
+  {
+    marketCache.Quote(httpWatchlist.Type(i), httpWatchlist.Symbol(i), financeLatest.prices[i], financeLatest.yesterdayPrices[i]);
+    financeLatest.isCached[i] = financeLatest.prices[i] != 0;
+  }
+  currencyUpdateDate = marketCache.CurrencyDate();
+  financeSnapshot.Publish(financeLatest);
+  WeatherData cachedWeather = {};
+  int16_t cachedHumidity;
+  if (marketCache.Weather(cachedWeather.temp, cachedHumidity, cachedWeather.desc, sizeof(cachedWeather.desc)))
+  {
+    cachedWeather.humi = cachedHumidity;
+    cachedWeather.isCached = true;
+    weatherSnapshot.Publish(cachedWeather);
+  }
+  bootLog.Mark(BootCache);
 
-  // setup http get task
-  tft.print("[HTTP] Create task...");
-  queueHttpGet = xQueueCreate(10, sizeof(RequestHttpGet));
+  // wifi and NTP come up in the background, the HTTP task waits for the connection on its own
+  WiFi.begin(ssid, password);
+  configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
   xTaskCreatePinnedToCore(vTaskHttpGetCallback, "task_http_get", 8192, NULL, 1, &taskHttpGet, 0);
-  tft.println("ok");
-
-  if (currencyUpdateDate < (timeinfo.tm_year + 1900) * 10000 + (timeinfo.tm_mon + 1) * 100 + timeinfo.tm_mday)
-  {
-    tft.print("[HTTP] Update currency");
-    httpGetReq.type = Currency;
-    httpGetReq.index = 0;
-    xQueueSend(queueHttpGet, &httpGetReq, 100);
-    tft.print(".");
-    delay(1000);
-    httpGetReq.index = 1;
-    xQueueSend(queueHttpGet, &httpGetReq, 100);
-    tft.println(".ok");
-  }
-
-  tft.print("[HTTP] Update TWSE...");
-  httpGetReq.type = TWSE;
-  httpGetReq.index = 255;
-  xQueueSend(queueHttpGet, &httpGetReq, 100);
-  delay(STOCK_COUNT * 500);
-  tft.println("ok");
-
-  // setup complete
-  tft.println(" Welcome to ML-Display!");
-  delay(3000);
+  telemetry.WatchTask(taskHttpGet);
+  telemetry.WatchScheduler(httpScheduler);
+
+  // first fetches queue up now, currencies wait for the clock to tell whether the cached ones are from today
+  RequestHttpGet(TWSE, HTTP_JOB_ALL);
+  RequestHttpGet(Weather, 0);
+  isWeatherRequestedAtBoot = true;
+
+  renderScheduler.Begin();
   ChangeScreenState(MainScreen);
+  renderScheduler.Notify(RENDER_EVENT_HTTP); // draw the cached data now, not at the next tick
+  LogHeap("after setup");
 }
 
-String serialMsg;
+PlayerLinkFrame serialFrame;
 void loop()
 {
-  getLocalTime(&timeinfo);
+  // sleep until the next second, serial data, HTTP data, a player screen deadline, a marquee step or a telemetry sample
+  uint32_t playerWaitMs = screenState == PlayerScreen ? min(PlayerNextChangeMs(), playerMarquees.NextStepMs()) : RENDER_WAIT_FOREVER;
+  if (screenState == SpectrumScreen)
+    playerWaitMs = spectrum.NextStepMs(millis());
+  renderScheduler.Wait(min(playerWaitMs, telemetry.NextSampleMs()));
+  if (getLocalTime(&timeinfo, 0) && !isClockSynced)
+  {
+    isClockSynced = true;
+    bootLog.Mark(BootClock);
+    isFinancePrinted = false; // a cached currency may turn current
+
+    // daily, unless the cached rates are from today
+    if (currencyUpdateDate < DateNumber(timeinfo))
+    {
+      RequestHttpGet(Currency, 0);
+      RequestHttpGet(Currency, 1);
+    }
+  }
 
-  if (Serial.available())
+  // handle every complete frame, a partial one stays in the ring until its end arrives
+  while (playerLink.Next(serialFrame))
   {
-    serialMsg = Serial.readStringUntil('\n');
-    ScreenState targetScreenState = (ScreenState)serialMsg.substring(0, serialMsg.indexOf('$')).toInt();
-    ChangeScreenState(targetScreenState);
+    // telemetry and watchlist commands share the link, told apart by their screen value
+    if (serialFrame.screen == TELEMETRY_SCREEN)
+    {
+      telemetry.Command(serialFrame);
+      if (serialFrame.field == TELEMETRY_FIELD_DUMP)
+        PrintStats();
+      continue;
+    }
+    if (serialFrame.screen == WATCHLIST_SCREEN)
+    {
+      WatchlistCommand(serialFrame);
+      continue;
+    }
+    ChangeScreenState((ScreenState)serialFrame.screen);
     if (screenState == PlayerScreen)
     {
-      ScreenUIUpdatePlayer(serialMsg);
+      ScreenUIUpdatePlayer(serialFrame);
+    }
+    // levels straight from the frame, frames arriving together fold into one step
+    else if (screenState == SpectrumScreen)
+    {
+      spectrum.Feed(serialFrame);
     }
-    serialMsg = "";
   }
 
+  if (financeSnapshot.Version() != financeVersionRecorded)
+    RecordIntradayTicks();
+
   switch (screenState)
   {
   case MainScreen:
     ScreenUIUpdateMain();
     break;
+  case PlayerScreen:
+    TFTPrintPlayerSongPosition();
+    if (lyricTimeline.Count())
+      TFTPrintPlayerTimelineLyric();
+    {
+      TelemetrySpan span(telemetry, WidgetMarquee);
+      playerMarquees.Step(compositor);
+    }
+    break;
+  case SpectrumScreen:
+    spectrum.Step(millis());
+    break;
+  }
+
+  // push everything drawn in this frame at once
+  {
+    TelemetrySpan span(telemetry, WidgetFlush);
+    compositor.Flush();
+  }
+  if (screenState == SpectrumScreen)
+    spectrum.Flushed();
+  bootLog.Mark(BootFirstFrame);
+  telemetry.Poll();
+
+  if (STATS_LOG_INTERVAL_SEC > 0 && millis() - statsPrintedMillis >= STATS_LOG_INTERVAL_SEC * 1000UL)
+  {
+    PrintStats();
+    statsPrintedMillis = millis();
   }
 }
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "market_cache.h"
+
+static uint8_t *Put(uint8_t *p, const void *value, size_t size)
+{
+  memcpy(p, value, size);
+  return p + size;
+}
+
+// the old firmware's currencies in its key order
+static const char *const legacySymbols[MARKET_CACHE_LEGACY_COUNT] = {"JPY", "USD"};
+
+static const uint8_t *Get(const uint8_t *p, void *value, size_t size)
+{
+  memcpy(value, p, size);
+  return p + size;
+}
+
+// a blob that does not check out leaves the cache empty
+bool MarketCache::Load(Preferences &prefs, const char *key)
+{
+  uint8_t blob[MARKET_CACHE_BLOB_MAX];
+  size_t size = prefs.getBytesLength(key);
+  if (size < MARKET_CACHE_HEADER || size > sizeof(blob) || prefs.getBytes(key, blob, sizeof(blob)) != size)
+  {
+    return false;
+  }
+
+  uint8_t newCount = blob[1];
+  if (blob[0] != MARKET_CACHE_VERSION || newCount > WATCHLIST_MAX_SYMBOLS ||
+      size != (size_t)(MARKET_CACHE_HEADER + newCount * MARKET_CACHE_ENTRY_SIZE) ||
+      blob[MARKET_CACHE_HEADER - 1] != '\0')
+  {
+    return false;
+  }
+  for (uint8_t i = 0; i < newCount; i++)
+  {
+    if (blob[MARKET_CACHE_HEADER + newCount * WATCHLIST_SYMBOL_SIZE + i] > WatchCurrency)
+      return false;
+  }
+
+  const uint8_t *p = blob + 2;
+  p = Get(p, &humidity, 2);
+  p = Get(p, &stats.lifetimeWrites, 4);
+  p = Get(p, &currencyDate, 4);
+  p = Get(p, &temp, 4);
+  p = Get(p, desc, MARKET_CACHE_DESC_SIZE);
+  p = Get(p, symbols, newCount * WATCHLIST_SYMBOL_SIZE);
+  p = Get(p, types, newCount);
+  p = Get(p, prices, newCount * 4);
+  Get(p, yesterdayPrices, newCount * 4);
+  count = newCount;
+  isLoaded = true;
+  return true;
+}
+
+// currencies and their date as the firmware kept them before the blob: by
+// index into its fixed list, 0 - 2 stocks that were never stored
+bool MarketCache::LoadLegacy(Preferences &prefs, const Watchlist &list)
+{
+  if (!prefs.isKey(MARKET_CACHE_LEGACY_DATE_KEY))
+  {
+    return false;
+  }
+  isLegacy = true;
+  // the blob is newer when there is one, the old keys are only cleaned up
+  if (isLoaded)
+  {
+    return true;
+  }
+
+  float newPrices[WATCHLIST_MAX_SYMBOLS] = {};
+  float newYesterdayPrices[WATCHLIST_MAX_SYMBOLS] = {};
+  bool isRecovered = false;
+  char key[16];
+  for (uint8_t index = 0; index < MARKET_CACHE_LEGACY_COUNT; index++)
+  {
+    int16_t i = list.Find(WatchCurrency, legacySymbols[index]);
+    if (i < 0)
+      continue;
+    snprintf(key, sizeof(key), "c_%u", MARKET_CACHE_LEGACY_FIRST + index);
+    newPrices[i] = prefs.getFloat(key, 0.0F);
+    snprintf(key, sizeof(key), "c_y_%u", MARKET_CACHE_LEGACY_FIRST + index);
+    newYesterdayPrices[i] = prefs.getFloat(key, 0.0F);
+    isRecovered |= newPrices[i] > 0 && isfinite(newPrices[i]);
+  }
+  // a date without prices would pass for today's rates and hold back the request
+  if (isRecovered)
+  {
+    StageQuotes(list, newPrices, newYesterdayPrices);
+    StageCurrencyDate(prefs.getUInt(MARKET_CACHE_LEGACY_DATE_KEY, 0U));
+  }
+  return true;
+}
+
+bool MarketCache::Commit(Preferences &prefs, const char *key)
+{
+  uint32_t lifetimeWrites = stats.lifetimeWrites + 1;
+  uint8_t blob[MARKET_CACHE_BLOB_MAX];
+  uint8_t *p = blob;
+  *p++ = MARKET_CACHE_VERSION;
+  *p++ = count;
+  p = Put(p, &humidity, 2);
+  p = Put(p, &lifetimeWrites, 4);
+  p = Put(p, &currencyDate, 4);
+  p = Put(p, &temp, 4);
+  p = Put(p, desc, MARKET_CACHE_DESC_SIZE);
+  p = Put(p, symbols, count * WATCHLIST_SYMBOL_SIZE);
+  p = Put(p, types, count);
+  p = Put(p, prices, count * 4);
+  p = Put(p, yesterdayPrices, count * 4);
+
+  size_t size = p - blob;
+  if (prefs.putBytes(key, blob, size) != size)
+  {
+    return false;
+  }
+
+  // data entries plus the blob's own index entry
+  stats.lifetimeWrites = lifetimeWrites;
+  stats.writes++;
+  stats.bytesWritten += ((size + MARKET_CACHE_NVS_ENTRY - 1) / MARKET_CACHE_NVS_ENTRY + 2) * MARKET_CACHE_NVS_ENTRY;
+  isDirty = false;
+  commitMillis = millis();
+  if (isLegacy)
+  {
+    RemoveLegacy(prefs);
+  }
+  return true;
+}
+
+// only once the blob holds their values
+void MarketCache::RemoveLegacy(Preferences &prefs)
+{
+  char key[16];
+  for (uint8_t index = 0; index < MARKET_CACHE_LEGACY_COUNT; index++)
+  {
+    snprintf(key, sizeof(key), "c_%u", MARKET_CACHE_LEGACY_FIRST + index);
+    prefs.remove(key);
+    snprintf(key, sizeof(key), "c_y_%u", MARKET_CACHE_LEGACY_FIRST + index);
+    prefs.remove(key);
+  }
+  prefs.remove(MARKET_CACHE_LEGACY_DATE_KEY);
+  isLegacy = false;
+}
+
+bool MarketCache::IsCommitDue(bool isForced) const
+{
+  return isDirty && (isForced || millis() - commitMillis >= MARKET_CACHE_COMMIT_INTERVAL_MS);
+}
+
+void MarketCache::MarkChanged()
+{
+  if (isDirty)
+    stats.merged++;
+  isDirty = true;
+}
+
+// floats compare bitwise, so a NaN price does not count as a change every time
+void MarketCache::StageQuotes(const Watchlist &list, const float *newPrices, const float *newYesterdayPrices)
+{
+  bool isChanged = list.Count() != count;
+  for (uint8_t i = 0; i < list.Count(); i++)
+  {
+    isChanged = isChanged || types[i] != list.Type(i) ||
+                memcmp(symbols[i], list.Symbol(i), WATCHLIST_SYMBOL_SIZE) != 0 ||
+                memcmp(&prices[i], &newPrices[i], 4) != 0 ||
+                memcmp(&yesterdayPrices[i], &newYesterdayPrices[i], 4) != 0;
+    types[i] = list.Type(i);
+    memcpy(symbols[i], list.Symbol(i), WATCHLIST_SYMBOL_SIZE);
+    prices[i] = newPrices[i];
+    yesterdayPrices[i] = newYesterdayPrices[i];
+  }
+  count = list.Count();
+  if (isChanged)
+    MarkChanged();
+}
+
+void MarketCache::StageCurrencyDate(uint32_t date)
+{
+  if (date == currencyDate)
+    return;
+  currencyDate = date;
+  MarkChanged();
+}
+
+void MarketCache::StageWeather(float newTemp, int16_t newHumidity, const char *newDesc)
+{
+  char padded[MARKET_CACHE_DESC_SIZE] = {};
+  strlcpy(padded, newDesc, sizeof(padded));
+  if (memcmp(&temp, &newTemp, 4) == 0 && humidity == newHumidity && memcmp(desc, padded, sizeof(desc)) == 0)
+    return;
+  temp = newTemp;
+  humidity = newHumidity;
+  memcpy(desc, padded, sizeof(desc));
+  MarkChanged();
+}
+
+bool MarketCache::Quote(WatchType type, const char *symbol, float &price, float &yesterdayPrice) const
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (types[i] == type && strncmp(symbols[i], symbol, WATCHLIST_SYMBOL_SIZE) == 0)
+    {
+      price = prices[i];
+      yesterdayPrice = yesterdayPrices[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t MarketCache::CurrencyDate() const
+{
+  return currencyDate;
+}
+
+bool MarketCache::Weather(float &weatherTemp, int16_t &weatherHumidity, char *weatherDesc, size_t size) const
+{
+  if (desc[0] == '\0')
+  {
+    return false;
+  }
+  weatherTemp = temp;
+  weatherHumidity = humidity;
+  strlcpy(weatherDesc, desc, size);
+  return true;
+}
+
+const MarketCacheStats &MarketCache::Stats() const
+{
+  return stats;
+}
+
+float MarketCache::WearYears(const MarketCacheStats &stats)
+{
+  if (stats.bytesWritten == 0)
+  {
+    return INFINITY;
+  }
+  float bytesPerYear = (float)stats.bytesWritten / (millis() / 1000.0F) * 365 * 24 * 3600;
+  return (float)MARKET_CACHE_NVS_BYTES * MARKET_CACHE_ERASE_CYCLES / bytesPerYear;
+}
@@ -0,0 +1,284 @@
+#include "marquee.h"
+
+MarqueeStrip::MarqueeStrip(TFT_eSPI *display, int16_t rowHeight)
+    : sprites{TFT_eSprite(display), TFT_eSprite(display)}, rowHeight(rowHeight)
+{
+}
+
+int8_t MarqueeStrip::Acquire(int8_t row, int16_t width)
+{
+  if (row < 0)
+  {
+    for (row = 0; row < MARQUEE_MAX && (usedRows & 1 << row); row++)
+    {
+    }
+    if (row == MARQUEE_MAX)
+    {
+      return -1;
+    }
+  }
+  usedRows |= 1 << row;
+  rowWidths[row] = width;
+
+  int16_t stripWidth = 0;
+  uint8_t rows = 0;
+  for (uint8_t i = 0; i < MARQUEE_MAX; i++)
+  {
+    if (usedRows & 1 << i)
+    {
+      stripWidth = max(stripWidth, rowWidths[i]);
+      rows = i + 1;
+    }
+  }
+  stripWidth = (stripWidth + MARQUEE_STRIP_STEP - 1) / MARQUEE_STRIP_STEP * MARQUEE_STRIP_STEP;
+
+  TFT_eSprite &sprite = sprites[current];
+  if (sprite.created() && sprite.width() == stripWidth && sprite.height() == rows * rowHeight)
+  {
+    return row;
+  }
+  // a smaller strip that could not be allocated leaves the bigger one in place
+  if (!Resize(stripWidth, rows) && !(sprite.width() >= width && sprite.height() >= RowY(row) + rowHeight))
+  {
+    Release(row);
+    return -1;
+  }
+  return row;
+}
+
+void MarqueeStrip::Release(int8_t row)
+{
+  usedRows &= ~(1 << row);
+  if (usedRows == 0)
+  {
+    sprites[current].deleteSprite();
+  }
+}
+
+bool MarqueeStrip::Resize(int16_t width, uint8_t rows)
+{
+  TFT_eSprite &from = sprites[current];
+  TFT_eSprite &to = sprites[current ^ 1];
+  to.setColorDepth(16);
+  if (to.createSprite(width, rows * rowHeight) == nullptr)
+  {
+    return false;
+  }
+  bytesPeak = max<uint32_t>(bytesPeak, Bytes() + (uint32_t)width * rows * rowHeight * sizeof(uint16_t));
+
+  // rows in use keep their text, it fits the new size
+  if (from.created())
+  {
+    const uint16_t *src = (const uint16_t *)from.getPointer();
+    uint16_t *dst = (uint16_t *)to.getPointer();
+    int16_t copyWidth = min<int16_t>(width, from.width());
+    int16_t copyHeight = min<int16_t>(rows * rowHeight, from.height());
+    for (int16_t line = 0; line < copyHeight; line++)
+    {
+      memcpy(dst + line * width, src + line * from.width(), copyWidth * sizeof(uint16_t));
+    }
+    from.deleteSprite();
+  }
+  current ^= 1;
+  return true;
+}
+
+TFT_eSprite &MarqueeStrip::Sprite()
+{
+  return sprites[current];
+}
+
+int16_t MarqueeStrip::RowY(int8_t row)
+{
+  return row * rowHeight;
+}
+
+int16_t MarqueeStrip::RowHeight()
+{
+  return rowHeight;
+}
+
+uint32_t MarqueeStrip::Bytes()
+{
+  TFT_eSprite &sprite = sprites[current];
+  return sprite.created() ? (uint32_t)sprite.width() * sprite.height() * sizeof(uint16_t) : 0;
+}
+
+uint32_t MarqueeStrip::BytesPeak()
+{
+  return bytesPeak;
+}
+
+Marquee::Marquee(MarqueeStrip &strip, int16_t x, int16_t y, int16_t w, int16_t textY)
+    : strip(strip), x(x), y(y), w(w), textY(textY)
+{
+}
+
+bool Marquee::Start(GlyphCache &glyphs, const char *text, uint16_t length, uint16_t fg, uint16_t bg)
+{
+  int16_t textWidth = glyphs.TextWidth(text, length);
+  if (textWidth <= w)
+  {
+    Stop();
+    return false;
+  }
+
+  // the row is kept from the previous text, so a new lyric line does not free and reallocate the strip
+  isRunning = false;
+  int16_t width = min<int32_t>(textWidth + MARQUEE_GAP, MARQUEE_MAX_STRIP_WIDTH);
+  row = strip.Acquire(row, width);
+  if (row < 0)
+  {
+    return false; // without a strip the caller draws the text cut at the edge, as without a marquee
+  }
+
+  // rasterized once here, clipped to the row, glyphs past its end are cut
+  stripWidth = width;
+  int16_t h = strip.RowHeight();
+  TFT_eSprite &sprite = strip.Sprite();
+  sprite.setViewport(0, strip.RowY(row), stripWidth, h);
+  sprite.fillRect(0, 0, stripWidth, h, bg);
+  glyphs.DrawString(sprite, text, length, 0, textY, fg, bg);
+  sprite.resetViewport();
+
+  isRunning = true;
+  startMillis = millis();
+  periodMs = MARQUEE_PAUSE_MS + (uint32_t)stripWidth * 1000 / MARQUEE_SPEED_PX_PER_SEC;
+  shownOffset = -1;
+  return true;
+}
+
+void Marquee::Stop()
+{
+  isRunning = false;
+  if (row >= 0)
+  {
+    strip.Release(row);
+    row = -1;
+  }
+}
+
+bool Marquee::IsRunning()
+{
+  return isRunning;
+}
+
+bool Marquee::Step(Compositor &compositor, unsigned long nowMillis)
+{
+  if (!isRunning)
+  {
+    return false;
+  }
+  int16_t offset = Offset(nowMillis);
+  if (offset == shownOffset)
+  {
+    return false;
+  }
+  compositor.BlitWrapped(strip.Sprite(), offset, strip.RowY(row), x, y, w, strip.RowHeight(), stripWidth);
+  shownOffset = offset;
+  return true;
+}
+
+// ms until the window moves by a pixel, or the pause at the start ends
+uint32_t Marquee::NextStepMs(unsigned long nowMillis)
+{
+  uint32_t elapsedMs = (nowMillis - startMillis) % periodMs;
+  if (elapsedMs < MARQUEE_PAUSE_MS)
+  {
+    return MARQUEE_PAUSE_MS - elapsedMs;
+  }
+  uint32_t nextMs = MARQUEE_PAUSE_MS + ((uint32_t)Offset(nowMillis) + 1) * 1000 / MARQUEE_SPEED_PX_PER_SEC;
+  return nextMs > elapsedMs ? nextMs - elapsedMs : 0;
+}
+
+// resting at 0 through the pause, then one pixel per 1/speed second until the repeat is back at 0
+int16_t Marquee::Offset(unsigned long nowMillis)
+{
+  uint32_t elapsedMs = (nowMillis - startMillis) % periodMs;
+  if (elapsedMs < MARQUEE_PAUSE_MS)
+  {
+    return 0;
+  }
+  return (elapsedMs - MARQUEE_PAUSE_MS) * MARQUEE_SPEED_PX_PER_SEC / 1000 % stripWidth;
+}
+
+void MarqueeGroup::Add(Marquee &marquee)
+{
+  if (count < MARQUEE_MAX)
+  {
+    marquees[count++] = &marquee;
+  }
+}
+
+void MarqueeGroup::Step(Compositor &compositor)
+{
+  unsigned long nowMillis = millis();
+  if (nowMillis - frameMillis < MARQUEE_FRAME_MS)
+  {
+    return;
+  }
+  frameMillis = nowMillis;
+
+  unsigned long startMicros = micros();
+  bool isStepped = false;
+  for (uint8_t k = 0; k < count; k++)
+  {
+    uint8_t i = (first + k) % count;
+    if (!marquees[i]->IsRunning())
+    {
+      continue;
+    }
+    // over budget, the rest go first next frame and catch up to the clock then
+    if (micros() - startMicros >= MARQUEE_FRAME_BUDGET_US)
+    {
+      stats.deferred++;
+      first = i;
+      break;
+    }
+    if (marquees[i]->Step(compositor, nowMillis))
+    {
+      stats.steps++;
+      isStepped = true;
+    }
+  }
+
+  if (isStepped)
+  {
+    stats.frames++;
+    stats.busyMicrosMax = max<uint32_t>(stats.busyMicrosMax, micros() - startMicros);
+  }
+}
+
+void MarqueeGroup::StopAll()
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    marquees[i]->Stop();
+  }
+}
+
+uint32_t MarqueeGroup::NextStepMs()
+{
+  unsigned long nowMillis = millis();
+  uint32_t waitMs = UINT32_MAX;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (marquees[i]->IsRunning())
+    {
+      waitMs = min(waitMs, marquees[i]->NextStepMs(nowMillis));
+    }
+  }
+  if (waitMs == UINT32_MAX)
+  {
+    return waitMs;
+  }
+  // not before the frame interval is over
+  uint32_t frameElapsedMs = nowMillis - frameMillis;
+  uint32_t frameWaitMs = frameElapsedMs < MARQUEE_FRAME_MS ? MARQUEE_FRAME_MS - frameElapsedMs : 0;
+  return max(waitMs, frameWaitMs);
+}
+
+const MarqueeStats &MarqueeGroup::Stats()
+{
+  return stats;
+}
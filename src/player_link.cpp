@@ -0,0 +1,204 @@
+#include "player_link.h"
+
+// nibble table, small enough to stay in cache and still two lookups per byte
+static const uint16_t crc16Table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+uint16_t PlayerLinkCrc16(const uint8_t *data, uint16_t length, uint16_t crc)
+{
+  for (uint16_t i = 0; i < length; i++)
+  {
+    crc = (crc << 4) ^ crc16Table[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (crc << 4) ^ crc16Table[(crc >> 12) ^ (data[i] & 0x0F)];
+  }
+  return crc;
+}
+
+uint32_t PlayerLinkU32(const PlayerLinkFrame &frame)
+{
+  if (frame.type != LinkU32 || frame.payload.length < 4)
+  {
+    return 0;
+  }
+
+  const uint8_t *p = (const uint8_t *)frame.payload.data;
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// one binary frame to the host, whatever mode the link reads in. Built in one
+// buffer and written in one call, so frames from different tasks never mix.
+void PlayerLinkWrite(Print &out, int8_t screen, uint8_t field, PlayerLinkType type, const uint8_t *payload, uint16_t length)
+{
+  uint8_t frame[SERIAL_RX_MAX_LINE];
+  length = min<uint16_t>(length, PLAYER_LINK_MAX_BODY - 3);
+  uint16_t bodyLength = 3 + length;
+  frame[0] = PLAYER_LINK_SYNC;
+  frame[1] = bodyLength;
+  frame[2] = bodyLength >> 8;
+  frame[3] = screen;
+  frame[4] = field;
+  frame[5] = type;
+  memcpy(frame + PLAYER_LINK_HEADER_SIZE + 3, payload, length);
+  uint16_t crc = PlayerLinkCrc16(frame + 1, 2 + bodyLength);
+  uint8_t *trailer = frame + PLAYER_LINK_HEADER_SIZE + bodyLength;
+  trailer[0] = crc;
+  trailer[1] = crc >> 8;
+  out.write(frame, PLAYER_LINK_HEADER_SIZE + bodyLength + PLAYER_LINK_CRC_SIZE);
+}
+
+void PlayerLinkLog::Begin(Print &output, PlayerLink &playerLink, int8_t logScreen, uint8_t logField)
+{
+  out = &output;
+  link = &playerLink;
+  screen = logScreen;
+  field = logField;
+}
+
+size_t PlayerLinkLog::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t PlayerLinkLog::write(const uint8_t *buffer, size_t size)
+{
+  if (out == nullptr)
+  {
+    return 0;
+  }
+  if (link->Mode() == LinkModeText)
+  {
+    return out->write(buffer, size);
+  }
+
+  // a println ends in a write of only the line end, nothing left to send
+  size_t length = size;
+  while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == '\r'))
+  {
+    length--;
+  }
+  if (length > 0)
+  {
+    PlayerLinkWrite(*out, screen, field, LinkText, buffer, min<size_t>(length, PLAYER_LINK_MAX_BODY - 3));
+  }
+  return size;
+}
+
+void PlayerLink::Begin(SerialRx &serialRx, Print &ackOut)
+{
+  rx = &serialRx;
+  ack = &ackOut;
+}
+
+bool PlayerLink::Next(PlayerLinkFrame &frame)
+{
+  if (pendingConsume)
+  {
+    rx->Consume(pendingConsume);
+    pendingConsume = 0;
+  }
+
+  while (true)
+  {
+    if (mode == LinkModeText)
+    {
+      // handshake is only looked for at a line boundary
+      if (!rx->IsLineInProgress() && rx->Available() && rx->Peek(0) == PLAYER_LINK_HANDSHAKE_BINARY)
+      {
+        rx->Consume(1);
+        ack->write(PLAYER_LINK_HANDSHAKE_BINARY);
+        mode = LinkModeBinary;
+        rx->SetBinary(true);
+        continue;
+      }
+      return NextText(frame);
+    }
+
+    if (rx->Available() && rx->Peek(0) == PLAYER_LINK_HANDSHAKE_TEXT)
+    {
+      rx->Consume(1);
+      mode = LinkModeText;
+      rx->SetBinary(false);
+      continue;
+    }
+    return NextBinary(frame);
+  }
+}
+
+PlayerLinkMode PlayerLink::Mode()
+{
+  return mode;
+}
+
+const PlayerLinkStats &PlayerLink::Stats()
+{
+  return stats;
+}
+
+bool PlayerLink::NextText(PlayerLinkFrame &frame)
+{
+  SerialSlice line;
+  if (!rx->NextLine(line))
+  {
+    return false;
+  }
+
+  int firstSeparator = SliceIndexOf(line, '$');
+  int lastSeparator = SliceLastIndexOf(line, '$');
+  frame.screen = SliceToInt(SliceSub(line, 0, firstSeparator));
+  frame.field = firstSeparator < 0 ? PLAYER_LINK_NO_FIELD : SliceToInt(SliceSub(line, firstSeparator + 1, lastSeparator));
+  frame.type = LinkText;
+  frame.payload = SliceSub(line, lastSeparator + 1, line.length);
+  stats.textFrames++;
+  return true;
+}
+
+bool PlayerLink::NextBinary(PlayerLinkFrame &frame)
+{
+  uint32_t available;
+  while ((available = rx->Available()) > 0)
+  {
+    if (rx->Peek(0) != PLAYER_LINK_SYNC)
+    {
+      rx->Consume(1);
+      stats.resyncBytes++;
+      continue;
+    }
+    if (available < PLAYER_LINK_HEADER_SIZE)
+    {
+      return false;
+    }
+
+    uint16_t length = rx->Peek(1) | rx->Peek(2) << 8;
+    if (length < 3 || length > PLAYER_LINK_MAX_BODY)
+    {
+      rx->Consume(1);
+      stats.badLengths++;
+      continue;
+    }
+    uint32_t frameSize = PLAYER_LINK_HEADER_SIZE + length + PLAYER_LINK_CRC_SIZE;
+    if (available < frameSize)
+    {
+      return false;
+    }
+
+    // length field + body in one slice, so the crc runs over contiguous memory
+    SerialSlice body = rx->Slice(1, length + 2);
+    uint16_t crc = rx->Peek(frameSize - 2) | rx->Peek(frameSize - 1) << 8;
+    if (PlayerLinkCrc16((const uint8_t *)body.data, body.length) != crc)
+    {
+      rx->Consume(1);
+      stats.crcErrors++;
+      continue;
+    }
+
+    frame.screen = (int8_t)body.data[2];
+    frame.field = body.data[3];
+    frame.type = (PlayerLinkType)body.data[4];
+    frame.payload = SliceSub(body, 5, body.length);
+    pendingConsume = frameSize;
+    stats.binaryFrames++;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,74 @@
+#include "position_clock.h"
+#include <esp_timer.h>
+
+void PositionClock::Sync(uint32_t hostMs)
+{
+  int64_t now = esp_timer_get_time();
+  int32_t error = (int32_t)(hostMs - Estimate(now));
+  uint32_t absError = abs(error);
+
+  stats.syncs++;
+  stats.lastErrorMs = error;
+  if (absError > POSITION_CLOCK_SNAP_MS || !isPlaying)
+  {
+    // seek, track change or paused: nothing to slew against
+    if (absError > POSITION_CLOCK_SNAP_MS)
+      stats.snaps++;
+    correctionMs = 0;
+  }
+  else
+  {
+    stats.maxAbsErrorMs = max(stats.maxAbsErrorMs, absError);
+    stats.meanAbsErrorMs = (stats.meanAbsErrorMs * 7 + absError) / 8;
+    if (hasPlayedSinceSync && now > lastSyncMicros)
+    {
+      int32_t ppm = (int64_t)error * 1000000000LL / (now - lastSyncMicros);
+      stats.driftPpm = (stats.driftPpm * 7 + ppm) / 8;
+    }
+    correctionMs = error;
+    hostMs -= error; // keep the local estimate, slew the difference in
+  }
+
+  baseMs = hostMs;
+  baseMicros = now;
+  lastSyncMicros = now;
+  hasPlayedSinceSync = isPlaying;
+}
+
+void PositionClock::SetPlaying(bool playing)
+{
+  if (playing == isPlaying)
+  {
+    return;
+  }
+
+  int64_t now = esp_timer_get_time();
+  baseMs = Estimate(now);
+  baseMicros = now;
+  correctionMs = 0;
+  isPlaying = playing;
+  hasPlayedSinceSync = false;
+}
+
+uint32_t PositionClock::PositionMs()
+{
+  return Estimate(esp_timer_get_time());
+}
+
+const PositionClockStats &PositionClock::Stats()
+{
+  return stats;
+}
+
+uint32_t PositionClock::Estimate(int64_t nowMicros)
+{
+  if (!isPlaying)
+  {
+    return baseMs;
+  }
+
+  uint32_t elapsedMs = (nowMicros - baseMicros) / 1000;
+  int32_t slewLimit = elapsedMs / POSITION_CLOCK_SLEW_DIVISOR;
+  int32_t applied = constrain(correctionMs, -slewLimit, slewLimit);
+  return baseMs + elapsedMs + applied;
+}
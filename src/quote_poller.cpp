@@ -0,0 +1,176 @@
+#include "quote_poller.h"
+
+void QuotePoller::Begin(Print &output)
+{
+  out = &output;
+  Reset();
+}
+
+void QuotePoller::Reset()
+{
+  unsigned long nowMillis = millis();
+  for (uint8_t i = 0; i < WATCHLIST_MAX_SYMBOLS; i++)
+  {
+    intervalMs[i] = QUOTE_POLL_MIN_MS;
+    dueMillis[i] = nowMillis;
+    tradeMs[i] = 0;
+  }
+  closingNext = 0;
+  requestMillis = nowMillis - QUOTE_POLL_GAP_MS;
+}
+
+uint8_t QuotePoller::Due(const struct tm &now, unsigned long nowMillis, uint8_t count, uint8_t *indexes, uint8_t maxCount)
+{
+  TwsePhase phase = Phase(now);
+  if (phase != TwseClosed && !isSessionOpen)
+  {
+    StartSession(now, nowMillis);
+  }
+  else if (phase == TwseClosed && isSessionOpen)
+  {
+    // the close is printed at 13:30, one more pass over every symbol picks it up
+    isSessionOpen = false;
+    isClosingPoll = true;
+    closingNext = 0;
+  }
+
+  if (!isSessionOpen && !isClosingPoll)
+  {
+    return 0;
+  }
+  if (nowMillis - requestMillis < QUOTE_POLL_GAP_MS)
+  {
+    return 0;
+  }
+
+  uint8_t dueCount = isClosingPoll ? DueClosing(count, indexes, maxCount) : 0;
+  if (isSessionOpen)
+  {
+    // nothing goes out before one symbol is due, then the soonest ones within reach come along
+    bool isAnyDue = false;
+    for (uint8_t i = 0; i < count; i++)
+      isAnyDue |= (long)(nowMillis - dueMillis[i]) >= 0;
+    while (isAnyDue && dueCount < maxCount)
+    {
+      int16_t soonest = -1;
+      for (uint8_t i = 0; i < count; i++)
+      {
+        if ((long)(dueMillis[i] - nowMillis) > QUOTE_POLL_AHEAD_MS)
+          continue;
+        if (soonest < 0 || (long)(dueMillis[i] - dueMillis[soonest]) < 0)
+          soonest = i;
+      }
+      if (soonest < 0)
+        break;
+      // rescheduled here too, so a symbol missing from the answer does not come back at once
+      dueMillis[soonest] = nowMillis + intervalMs[soonest];
+      indexes[dueCount++] = soonest;
+    }
+  }
+
+  if (dueCount > 0)
+  {
+    requestMillis = nowMillis;
+    stats.requests++;
+    stats.symbolsPolled += dueCount;
+  }
+  if (isClosingPoll && closingNext >= count)
+  {
+    EndSession();
+  }
+  return dueCount;
+}
+
+void QuotePoller::Polled(uint8_t index, uint64_t trade, uint64_t nowEpochMs, unsigned long nowMillis)
+{
+  if (index >= WATCHLIST_MAX_SYMBOLS)
+  {
+    return;
+  }
+
+  if (trade > tradeMs[index])
+  {
+    // the first trade seen after boot may be hours old, it says nothing about the polling
+    if (tradeMs[index] != 0 && isSessionOpen)
+    {
+      uint64_t ageMs = nowEpochMs > trade ? nowEpochMs - trade : 0;
+      stats.trades++;
+      stats.ageMsTotal += ageMs;
+      stats.ageMsMax = max<uint32_t>(stats.ageMsMax, min<uint64_t>(ageMs, UINT32_MAX));
+    }
+    intervalMs[index] = max<uint32_t>(QUOTE_POLL_MIN_MS, intervalMs[index] / 2);
+    tradeMs[index] = trade;
+  }
+  else
+  {
+    intervalMs[index] = min<uint32_t>(QUOTE_POLL_MAX_MS, intervalMs[index] * 2);
+  }
+  dueMillis[index] = nowMillis + intervalMs[index];
+}
+
+// weekdays only, exchange holidays are not known here
+TwsePhase QuotePoller::Phase(const struct tm &now)
+{
+  if (now.tm_wday == 0 || now.tm_wday == 6)
+  {
+    return TwseClosed;
+  }
+  int32_t second = now.tm_hour * 3600 + now.tm_min * 60 + now.tm_sec;
+  if (second < 9 * 3600)
+  {
+    return TwseClosed;
+  }
+  if (second < 13 * 3600 + 25 * 60)
+  {
+    return TwseContinuous;
+  }
+  if (second < 13 * 3600 + 30 * 60 + 15) // a few seconds for the closing print to show up
+  {
+    return TwseClosingAuction;
+  }
+  return TwseClosed;
+}
+
+const QuotePollerStats &QuotePoller::Stats()
+{
+  return stats;
+}
+
+float QuotePoller::AverageAgeSec()
+{
+  return stats.trades ? stats.ageMsTotal / 1000.0 / stats.trades : 0;
+}
+
+void QuotePoller::StartSession(const struct tm &now, unsigned long nowMillis)
+{
+  isSessionOpen = true;
+  isClosingPoll = false;
+  stats = {};
+  stats.date = (now.tm_year + 1900) * 10000 + (now.tm_mon + 1) * 100 + now.tm_mday;
+  for (uint8_t i = 0; i < WATCHLIST_MAX_SYMBOLS; i++)
+  {
+    intervalMs[i] = QUOTE_POLL_MIN_MS;
+    dueMillis[i] = nowMillis;
+  }
+}
+
+void QuotePoller::EndSession()
+{
+  isClosingPoll = false;
+  if (out != nullptr)
+  {
+    out->printf("[TWSE] session %u: %u requests, %u symbols polled, %u new trades, quote age avg %.1f / max %.1f s\n",
+                stats.date, stats.requests, stats.symbolsPolled, stats.trades, AverageAgeSec(), stats.ageMsMax / 1000.0);
+  }
+}
+
+// every symbol once, in index order, a batch per request
+uint8_t QuotePoller::DueClosing(uint8_t count, uint8_t *indexes, uint8_t maxCount)
+{
+  uint8_t dueCount = 0;
+  while (closingNext < count && dueCount < maxCount)
+  {
+    indexes[dueCount++] = closingNext++;
+  }
+  return dueCount;
+}
@@ -0,0 +1,68 @@
+#include "render_bench.h"
+
+RenderBench::RenderBench(Compositor &compositor)
+    : compositor(compositor)
+{
+}
+
+int8_t RenderBench::Add(const char *name, uint32_t budgetUs)
+{
+  if (caseCount >= RENDER_BENCH_MAX_CASES)
+  {
+    return -1;
+  }
+  cases[caseCount] = {name, budgetUs, 0, 0, 0, 0, 0};
+  return caseCount++;
+}
+
+void RenderBench::Run(int8_t id, const std::function<void()> &draw)
+{
+  if (id < 0 || id >= caseCount)
+  {
+    return;
+  }
+
+  // push what earlier code left dirty, so it is not billed to this run
+  compositor.Flush();
+  compositor.Sync();
+  uint32_t bytesBefore = compositor.Stats().bytesPushedTotal;
+
+  uint32_t startCycles = ESP.getCycleCount();
+  draw();
+  compositor.Flush();
+  compositor.Sync(); // the transfer still running is part of the frame
+  uint32_t cycles = ESP.getCycleCount() - startCycles;
+  uint32_t pixels = (compositor.Stats().bytesPushedTotal - bytesBefore) / sizeof(uint16_t);
+
+  RenderBenchCase &benchCase = cases[id];
+  benchCase.runs++;
+  benchCase.cyclesTotal += cycles;
+  benchCase.cyclesMax = max(benchCase.cyclesMax, cycles);
+  benchCase.pixelsTotal += pixels;
+  benchCase.pixelsMax = max(benchCase.pixelsMax, pixels);
+}
+
+bool RenderBench::Report()
+{
+  uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+  bool isWithinBudget = true;
+  for (uint8_t i = 0; i < caseCount; i++)
+  {
+    const RenderBenchCase &benchCase = cases[i];
+    if (benchCase.runs == 0)
+    {
+      continue;
+    }
+
+    uint32_t cyclesAvg = benchCase.cyclesTotal / benchCase.runs;
+    uint32_t maxUs = benchCase.cyclesMax / cyclesPerUs;
+    bool isOver = maxUs > benchCase.budgetUs;
+    isWithinBudget = isWithinBudget && !isOver;
+    Serial.printf("[BENCH] %-32s %3u runs, cycles avg %u / max %u, us avg %u / max %u, px avg %u / max %u, budget %u us%s\n",
+                  benchCase.name, benchCase.runs, cyclesAvg, benchCase.cyclesMax, cyclesAvg / cyclesPerUs, maxUs,
+                  (uint32_t)(benchCase.pixelsTotal / benchCase.runs), benchCase.pixelsMax, benchCase.budgetUs,
+                  isOver ? " OVER" : "");
+  }
+  Serial.printf("[BENCH] %s\n", isWithinBudget ? "PASS" : "FAIL");
+  return isWithinBudget;
+}
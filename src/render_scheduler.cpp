@@ -0,0 +1,89 @@
+#include "render_scheduler.h"
+#include <sys/time.h>
+
+void RenderScheduler::Begin()
+{
+  task = xTaskGetCurrentTaskHandle();
+
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = OnTick;
+  timerArgs.arg = this;
+  timerArgs.dispatch_method = ESP_TIMER_TASK;
+  timerArgs.name = "render_tick";
+  esp_timer_create(&timerArgs, &tickTimer);
+  ArmTick();
+
+  // first pass runs at once
+  Notify(RENDER_EVENT_TICK);
+  wakeMicros = windowStartMicros = esp_timer_get_time();
+}
+
+void RenderScheduler::Notify(uint32_t events)
+{
+  if (task != nullptr)
+  {
+    xTaskNotify(task, events, eSetBits);
+  }
+}
+
+uint32_t RenderScheduler::Wait(uint32_t timeoutMs)
+{
+  busyMicros += esp_timer_get_time() - wakeMicros;
+
+  uint32_t events = 0;
+#ifndef RENDER_SCHEDULER_DISABLE
+  TickType_t ticks = timeoutMs == RENDER_WAIT_FOREVER ? portMAX_DELAY : max<TickType_t>(pdMS_TO_TICKS(timeoutMs), 1);
+  xTaskNotifyWait(0, UINT32_MAX, &events, ticks);
+#else
+  xTaskNotifyWait(0, UINT32_MAX, &events, 0);
+#endif
+
+  wakeMicros = esp_timer_get_time();
+  windowWakeups++;
+  if (events & RENDER_EVENT_TICK)
+    stats.ticks++;
+  if (events & RENDER_EVENT_SERIAL)
+    stats.serialEvents++;
+  if (events & RENDER_EVENT_HTTP)
+    stats.httpEvents++;
+  if (events == 0)
+    stats.timeouts++;
+  UpdateRate(wakeMicros);
+  return events;
+}
+
+const RenderSchedulerStats &RenderScheduler::Stats()
+{
+  return stats;
+}
+
+// **Tick (esp_timer task)**
+void RenderScheduler::OnTick(void *arg)
+{
+  RenderScheduler *scheduler = (RenderScheduler *)arg;
+  scheduler->Notify(RENDER_EVENT_TICK);
+  scheduler->ArmTick();
+}
+
+// one shot to the next second boundary, re-aligned every time so NTP steps are followed
+void RenderScheduler::ArmTick()
+{
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  esp_timer_start_once(tickTimer, 1000000 - now.tv_usec + RENDER_TICK_MARGIN_US);
+}
+
+void RenderScheduler::UpdateRate(int64_t now)
+{
+  int64_t elapsed = now - windowStartMicros;
+  if (elapsed < RENDER_STATS_WINDOW_MS * 1000LL)
+  {
+    return;
+  }
+
+  stats.wakeupsPerSec = windowWakeups * 1000000.0F / elapsed;
+  stats.busyPercent = busyMicros * 100.0F / elapsed;
+  windowWakeups = 0;
+  busyMicros = 0;
+  windowStartMicros = now;
+}
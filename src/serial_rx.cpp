@@ -0,0 +1,233 @@
+#include "serial_rx.h"
+
+#define SERIAL_RX_MASK (SERIAL_RX_RING_SIZE - 1)
+
+void SerialRx::Begin(HardwareSerial &port)
+{
+  serial = &port;
+  serial->onReceive([this]()
+                    { Produce(); });
+  serial->onReceiveError([this](hardwareSerial_error_t error)
+                         {
+                           // the driver dropped bytes of the line in progress
+                           if (error == UART_BUFFER_FULL_ERROR || error == UART_FIFO_OVF_ERROR)
+                           {
+                             stats.uartErrors++;
+                             if (!isBinary.load(std::memory_order_relaxed))
+                               isDiscarding = true;
+                           } });
+}
+
+void SerialRx::OnData(std::function<void()> callback)
+{
+  onData = callback;
+}
+
+void SerialRx::SetBinary(bool binary)
+{
+  isBinary.store(binary, std::memory_order_relaxed);
+}
+
+// **Producer (UART event task)**
+void SerialRx::Produce()
+{
+  uint32_t headBefore = head.load(std::memory_order_relaxed);
+  uint8_t chunk[64];
+  int available;
+  while ((available = serial->available()) > 0)
+  {
+    size_t count = serial->read(chunk, min<size_t>(available, sizeof(chunk)));
+    for (size_t i = 0; i < count; i++)
+    {
+      Push(chunk[i]);
+    }
+  }
+
+  if (isMarkerPending && !isBinary.load(std::memory_order_relaxed))
+  {
+    WriteMarker();
+  }
+
+  if (onData && head.load(std::memory_order_relaxed) != headBefore)
+  {
+    onData();
+  }
+}
+
+void SerialRx::Push(uint8_t c)
+{
+  uint32_t h = head.load(std::memory_order_relaxed);
+  bool isFull = h - tail.load(std::memory_order_acquire) >= SERIAL_RX_RING_SIZE;
+  if (isBinary.load(std::memory_order_relaxed))
+  {
+    // 0x0A is payload here, only the frame the gap falls in is lost, to its CRC
+    isDiscarding = false;
+    isMarkerPending = false;
+    if (isFull)
+    {
+      stats.overrunBytes++;
+      return;
+    }
+    ring[h & SERIAL_RX_MASK] = c;
+    head.store(h + 1, std::memory_order_release);
+    stats.bytes++;
+    return;
+  }
+
+  if (isMarkerPending)
+  {
+    WriteMarker();
+    h = head.load(std::memory_order_relaxed);
+    isFull = h - tail.load(std::memory_order_acquire) >= SERIAL_RX_RING_SIZE;
+  }
+  if (!isDiscarding && !isMarkerPending && !isFull)
+  {
+    ring[h & SERIAL_RX_MASK] = c;
+    head.store(h + 1, std::memory_order_release);
+    stats.bytes++;
+    return;
+  }
+
+  // the line in progress is damaged, drop the rest of it and cancel it once it ends
+  stats.overrunBytes++;
+  if (c == '\n')
+  {
+    isDiscarding = false;
+    isMarkerPending = true;
+  }
+  else
+  {
+    isDiscarding = true;
+  }
+}
+
+bool SerialRx::WriteMarker()
+{
+  uint32_t h = head.load(std::memory_order_relaxed);
+  if (SERIAL_RX_RING_SIZE - (h - tail.load(std::memory_order_acquire)) < 2)
+  {
+    return false;
+  }
+
+  ring[h & SERIAL_RX_MASK] = SERIAL_RX_CANCEL;
+  ring[(h + 1) & SERIAL_RX_MASK] = '\n';
+  head.store(h + 2, std::memory_order_release);
+  isMarkerPending = false;
+  return true;
+}
+
+// **Consumer (loop task)**
+bool SerialRx::NextLine(SerialSlice &line)
+{
+  if (isHolding)
+  {
+    Release();
+  }
+
+  uint32_t h = head.load(std::memory_order_acquire);
+  uint32_t t = tail.load(std::memory_order_relaxed);
+  while (scanPos != h)
+  {
+    uint8_t c = ring[scanPos & SERIAL_RX_MASK];
+    scanPos++;
+
+    if (c != '\n')
+    {
+      isLineCancelled |= c == SERIAL_RX_CANCEL;
+      if (scanPos - t > SERIAL_RX_MAX_LINE)
+      {
+        // overlong line, free its bytes now and skip the rest when it ends
+        if (!isSkippingLine)
+          stats.droppedFrames++;
+        isSkippingLine = true;
+        t = scanPos;
+        tail.store(t, std::memory_order_release);
+      }
+      continue;
+    }
+
+    uint32_t start = t;
+    uint32_t end = scanPos - 1;
+    if (end != start && ring[(end - 1) & SERIAL_RX_MASK] == '\r')
+      end--;
+
+    if (isSkippingLine || isLineCancelled)
+    {
+      if (isLineCancelled && !isSkippingLine)
+        stats.droppedFrames++;
+      isSkippingLine = false;
+      isLineCancelled = false;
+      t = scanPos;
+      tail.store(t, std::memory_order_release);
+      continue;
+    }
+
+    // in place, or copied to scratch when the line wraps around the end of the ring
+    line = Slice(0, end - start);
+
+    releasePos = scanPos;
+    isHolding = true;
+    stats.frames++;
+    return true;
+  }
+  return false;
+}
+
+void SerialRx::Release()
+{
+  if (!isHolding)
+  {
+    return;
+  }
+
+  tail.store(releasePos, std::memory_order_release);
+  isHolding = false;
+}
+
+bool SerialRx::IsLineInProgress()
+{
+  Release();
+  return scanPos != tail.load(std::memory_order_relaxed);
+}
+
+uint32_t SerialRx::Available()
+{
+  Release();
+  return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+}
+
+uint8_t SerialRx::Peek(uint32_t offset)
+{
+  return ring[(tail.load(std::memory_order_relaxed) + offset) & SERIAL_RX_MASK];
+}
+
+SerialSlice SerialRx::Slice(uint32_t offset, uint16_t length)
+{
+  uint32_t startIndex = (tail.load(std::memory_order_relaxed) + offset) & SERIAL_RX_MASK;
+  if (startIndex + length <= SERIAL_RX_RING_SIZE)
+  {
+    return {(const char *)ring + startIndex, length};
+  }
+
+  uint16_t firstPart = SERIAL_RX_RING_SIZE - startIndex;
+  memcpy(scratch, ring + startIndex, firstPart);
+  memcpy(scratch + firstPart, ring, length - firstPart);
+  return {scratch, length};
+}
+
+void SerialRx::Consume(uint32_t count)
+{
+  Release();
+  uint32_t t = tail.load(std::memory_order_relaxed) + count;
+  tail.store(t, std::memory_order_release);
+
+  // byte level reads restart line framing
+  scanPos = t;
+  isLineCancelled = false;
+  isSkippingLine = false;
+}
+
+const SerialRxStats &SerialRx::Stats()
+{
+  return stats;
+}
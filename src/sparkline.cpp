@@ -0,0 +1,104 @@
+#include "sparkline.h"
+
+Sparkline::Sparkline(TFT_eSprite &canvas, Compositor &compositor, int16_t x, int16_t y, int16_t w, int16_t h)
+    : canvas(canvas), compositor(compositor), x(x), y(y), w(w), h(h)
+{
+}
+
+void Sparkline::Draw(const IntradayHistory &history, uint8_t index)
+{
+  uint16_t count = history.Count(index);
+  uint32_t added = history.Appended(index) - drawnAppended;
+
+  // incremental only while the columns on screen are still part of the same session
+  if (!isDrawn || index != drawnIndex || added >= count || added >= (uint32_t)w || RangeFor(history, index) > range)
+  {
+    DrawFull(history, index);
+  }
+  else if (added > 0)
+  {
+    ShiftLeft(added);
+    // the previous newest column too, its minute may have moved on before the next one started
+    for (uint16_t age = 0; age <= added; age++)
+      DrawColumn(history, index, age);
+    compositor.MarkDirty(x, y, w, h);
+    stats.shifts++;
+  }
+  else if (history.Tick(index, 0) != drawnNewest)
+  {
+    DrawColumn(history, index, 0);
+    compositor.MarkDirty(x + w - 1, y, 1, h);
+  }
+
+  drawnAppended = history.Appended(index);
+  drawnNewest = count > 0 ? history.Tick(index, 0) : 0;
+}
+
+void Sparkline::Invalidate()
+{
+  isDrawn = false;
+}
+
+const SparklineStats &Sparkline::Stats()
+{
+  return stats;
+}
+
+void Sparkline::DrawFull(const IntradayHistory &history, uint8_t index)
+{
+  canvas.fillRect(x, y, w, h, TFT_BLACK);
+  range = RangeFor(history, index);
+  uint16_t shown = min<uint16_t>(history.Count(index), w);
+  for (uint16_t age = 0; age < shown; age++)
+    DrawColumn(history, index, age);
+  compositor.MarkDirty(x, y, w, h);
+
+  isDrawn = true;
+  drawnIndex = index;
+  stats.fullDraws++;
+}
+
+// a vertical segment from the previous minute's tick to this one, over the baseline
+void Sparkline::DrawColumn(const IntradayHistory &history, uint8_t index, uint16_t age)
+{
+  int16_t column = x + w - 1 - age;
+  canvas.drawFastVLine(column, y, h, TFT_BLACK);
+  canvas.drawPixel(column, TickY(0), SPARKLINE_BASELINE_COLOR);
+
+  int16_t tick = history.Tick(index, age);
+  int16_t tickY = TickY(tick);
+  int16_t previousY = age + 1 < history.Count(index) ? TickY(history.Tick(index, age + 1)) : tickY;
+  uint16_t color = tick > 0 ? SPARKLINE_UP_COLOR : tick < 0 ? SPARKLINE_DOWN_COLOR : SPARKLINE_FLAT_COLOR;
+  canvas.drawFastVLine(column, min(tickY, previousY), abs(tickY - previousY) + 1, color);
+  stats.columnsDrawn++;
+}
+
+// plain row moves in the 16 bit canvas, the freed columns on the right are drawn next
+void Sparkline::ShiftLeft(int16_t columns)
+{
+  uint16_t *pixels = (uint16_t *)canvas.getPointer();
+  int16_t stride = canvas.width();
+  for (int16_t row = y; row < y + h; row++)
+  {
+    uint16_t *line = pixels + row * stride + x;
+    memmove(line, line + columns, (w - columns) * sizeof(uint16_t));
+  }
+}
+
+int16_t Sparkline::TickY(int16_t tick)
+{
+  int16_t half = (h - 1) / 2;
+  int16_t tickY = y + half - (int32_t)tick * half / range;
+  return constrain(tickY, y, (int16_t)(y + h - 1));
+}
+
+// largest change on screen, rounded up to whole steps
+int16_t Sparkline::RangeFor(const IntradayHistory &history, uint8_t index)
+{
+  int32_t largest = 0;
+  uint16_t shown = min<uint16_t>(history.Count(index), w);
+  for (uint16_t age = 0; age < shown; age++)
+    largest = max<int32_t>(largest, abs(history.Tick(index, age)));
+  int32_t steps = max<int32_t>(1, (largest + SPARKLINE_RANGE_STEP - 1) / SPARKLINE_RANGE_STEP);
+  return min<int32_t>(steps * SPARKLINE_RANGE_STEP, INT16_MAX);
+}
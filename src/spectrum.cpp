@@ -0,0 +1,246 @@
+#include "spectrum.h"
+
+#define SPECTRUM_FULL_LEVEL (255UL << 8)
+
+Spectrum::Spectrum(TFT_eSprite &canvas, Compositor &compositor, int16_t x, int16_t y, int16_t w, int16_t h)
+    : canvas(canvas), compositor(compositor), x(x), y(y), w(w), h(h)
+{
+}
+
+void Spectrum::Begin(Print &output)
+{
+  out = &output;
+}
+
+bool Spectrum::Feed(const PlayerLinkFrame &frame)
+{
+  const uint8_t *p = (const uint8_t *)frame.payload.data;
+  uint16_t length = frame.payload.length;
+  if (frame.field != SPECTRUM_FIELD_BANDS || frame.type != LinkBytes || length < 7 || length - 6 > SPECTRUM_MAX_BANDS)
+  {
+    stats.badFrames++;
+    return false;
+  }
+
+  uint16_t frameSeq = p[0] | p[1] << 8;
+  if (stats.frames > 0)
+  {
+    // a seq running backwards is a host restart, not a loss
+    uint16_t gap = frameSeq - seq - 1;
+    if (gap < 0x8000)
+      stats.dropped += gap;
+  }
+  if (!isFrameDrawn)
+  {
+    stats.merged++;
+  }
+
+  uint8_t count = length - 6;
+  if (count != bandCount)
+  {
+    Layout(count);
+  }
+  // fall up to now first, so the new levels start their release from here
+  unsigned long nowMillis = millis();
+  Release(nowMillis);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint32_t level = (uint32_t)p[6 + i] << 8;
+    if (level > levels[i])
+      levels[i] = level;
+    if (levels[i] >= peaks[i])
+    {
+      peaks[i] = levels[i];
+      peakMillis[i] = nowMillis;
+    }
+  }
+
+  screen = frame.screen; // echoes go back to where the frame came from
+  field = frame.field;
+  seq = frameSeq;
+  hostMillis = p[2] | p[3] << 8 | p[4] << 16 | (uint32_t)p[5] << 24;
+  frameMicros = micros();
+  isFrameDrawn = false;
+  isFrameStepped = false;
+  stats.frames++;
+  return true;
+}
+
+void Spectrum::Step(unsigned long nowMillis)
+{
+  Release(nowMillis);
+  for (uint8_t i = 0; i < bandCount; i++)
+  {
+    DrawBand(i, Height(levels[i]), Height(peaks[i]));
+  }
+  if (!isFrameDrawn)
+  {
+    isFrameStepped = true;
+  }
+}
+
+void Spectrum::Flushed()
+{
+  if (!isFrameStepped)
+  {
+    return;
+  }
+  uint32_t latencyMicros = micros() - frameMicros;
+  isFrameDrawn = true;
+  isFrameStepped = false;
+  stats.drawnFrames++;
+  stats.latencyMicrosTotal += latencyMicros;
+  stats.latencyMicrosMax = max(stats.latencyMicrosMax, latencyMicros);
+
+  unsigned long nowMillis = millis();
+  // the first frame drawn answers at once, the host gets a round trip without waiting
+  if (out != nullptr && (stats.drawnFrames == 1 || nowMillis - echoMillis >= SPECTRUM_ECHO_MS))
+  {
+    echoMillis = nowMillis;
+    uint8_t payload[10] = {(uint8_t)seq, (uint8_t)(seq >> 8),
+                           (uint8_t)hostMillis, (uint8_t)(hostMillis >> 8), (uint8_t)(hostMillis >> 16), (uint8_t)(hostMillis >> 24),
+                           (uint8_t)latencyMicros, (uint8_t)(latencyMicros >> 8), (uint8_t)(latencyMicros >> 16), (uint8_t)(latencyMicros >> 24)};
+    PlayerLinkWrite(*out, screen, field, LinkBytes, payload, sizeof(payload));
+  }
+}
+
+void Spectrum::Invalidate()
+{
+  memset(barsDrawn, 0, sizeof(barsDrawn));
+  memset(peaksDrawn, 0, sizeof(peaksDrawn));
+}
+
+// a frame while bars or peaks are still falling, nothing when all are down
+uint32_t Spectrum::NextStepMs(unsigned long nowMillis)
+{
+  bool isMoving = false;
+  for (uint8_t i = 0; i < bandCount; i++)
+  {
+    isMoving |= levels[i] > 0 || peaks[i] > 0;
+  }
+  if (!isMoving)
+  {
+    return UINT32_MAX;
+  }
+  uint32_t elapsedMs = nowMillis - stepMillis;
+  return elapsedMs < SPECTRUM_FRAME_MS ? SPECTRUM_FRAME_MS - elapsedMs : 0;
+}
+
+const SpectrumStats &Spectrum::Stats()
+{
+  return stats;
+}
+
+uint32_t Spectrum::AverageLatencyMicros()
+{
+  return stats.drawnFrames ? stats.latencyMicrosTotal / stats.drawnFrames : 0;
+}
+
+void Spectrum::Layout(uint8_t count)
+{
+  bandCount = count;
+  bandWidth = w / count;
+  barWidth = bandWidth > 2 ? bandWidth - 1 : bandWidth; // a 1 px gap when there is room
+  bandsX = x + (w - bandWidth * count + bandWidth - barWidth) / 2;
+  memset(levels, 0, sizeof(levels));
+  memset(peaks, 0, sizeof(peaks));
+
+  canvas.fillRect(x, y, w, h, TFT_BLACK);
+  compositor.MarkDirty(x, y, w, h);
+  Invalidate();
+}
+
+// bars fall by elapsed time, peaks after their hold, all in 1/256 of a level
+void Spectrum::Release(unsigned long nowMillis)
+{
+  uint32_t elapsedMs = min<uint32_t>(nowMillis - stepMillis, 1000);
+  stepMillis = nowMillis;
+  for (uint8_t i = 0; i < bandCount; i++)
+  {
+    uint32_t fall = elapsedMs * SPECTRUM_RELEASE_PER_MS;
+    levels[i] = levels[i] > fall ? levels[i] - fall : 0;
+
+    uint32_t heldMs = nowMillis - peakMillis[i];
+    if (heldMs > SPECTRUM_PEAK_HOLD_MS)
+    {
+      fall = min<uint32_t>(elapsedMs, heldMs - SPECTRUM_PEAK_HOLD_MS) * SPECTRUM_PEAK_FALL_PER_MS;
+      peaks[i] = peaks[i] > fall ? peaks[i] - fall : 0;
+    }
+    peaks[i] = max(peaks[i], levels[i]);
+  }
+}
+
+void Spectrum::DrawBand(uint8_t band, int16_t barHeight, int16_t peakHeight)
+{
+  int16_t bandX = bandsX + band * bandWidth;
+  int16_t bottom = y + h;
+  int16_t barDrawn = barsDrawn[band];
+  int16_t peakDrawn = peaksDrawn[band];
+
+  // only the rows between the old and the new top
+  if (barHeight > barDrawn)
+  {
+    FillBar(bandX, bottom - barHeight, bottom - barDrawn);
+  }
+  else if (barHeight < barDrawn)
+  {
+    canvas.fillRect(bandX, bottom - barDrawn, barWidth, barDrawn - barHeight, TFT_BLACK);
+    compositor.MarkDirty(bandX, bottom - barDrawn, barWidth, barDrawn - barHeight);
+  }
+  stats.rowsDrawn += abs(barHeight - barDrawn);
+  barsDrawn[band] = barHeight;
+
+  // the mark sits on the bar top or above it, the bar may just have painted over it
+  if (peakHeight == peakDrawn && barHeight == barDrawn)
+  {
+    return;
+  }
+  if (peakDrawn > 0 && peakDrawn != peakHeight)
+  {
+    DrawPeakRow(bandX, peakDrawn, barHeight);
+  }
+  if (peakHeight > 0)
+  {
+    canvas.fillRect(bandX, bottom - peakHeight, barWidth, 1, SPECTRUM_PEAK_COLOR);
+    compositor.MarkDirty(bandX, bottom - peakHeight, barWidth, 1);
+    stats.rowsDrawn++;
+  }
+  peaksDrawn[band] = peakHeight;
+}
+
+void Spectrum::FillBar(int16_t bandX, int16_t top, int16_t bottom)
+{
+  const int16_t zoneTops[3] = {y, (int16_t)(y + h / 4), (int16_t)(y + h / 2)};
+  const int16_t zoneBottoms[3] = {zoneTops[1], zoneTops[2], (int16_t)(y + h)};
+  const uint16_t zoneColors[3] = {SPECTRUM_HIGH_COLOR, SPECTRUM_MID_COLOR, SPECTRUM_LOW_COLOR};
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    int16_t spanTop = max(top, zoneTops[i]);
+    int16_t spanBottom = min(bottom, zoneBottoms[i]);
+    if (spanTop < spanBottom)
+      canvas.fillRect(bandX, spanTop, barWidth, spanBottom - spanTop, zoneColors[i]);
+  }
+  compositor.MarkDirty(bandX, top, barWidth, bottom - top);
+}
+
+// puts back what was under an old peak mark
+void Spectrum::DrawPeakRow(int16_t bandX, int16_t height, int16_t barHeight)
+{
+  int16_t row = y + h - height;
+  if (height <= barHeight)
+  {
+    FillBar(bandX, row, row + 1);
+  }
+  else
+  {
+    canvas.fillRect(bandX, row, barWidth, 1, TFT_BLACK);
+    compositor.MarkDirty(bandX, row, barWidth, 1);
+  }
+  stats.rowsDrawn++;
+}
+
+// px of the area a level reaches
+int16_t Spectrum::Height(uint32_t level)
+{
+  return min<uint32_t>(level, SPECTRUM_FULL_LEVEL) * h / SPECTRUM_FULL_LEVEL;
+}
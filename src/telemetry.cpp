@@ -0,0 +1,164 @@
+#include "telemetry.h"
+
+static uint8_t *PutU32(uint8_t *p, uint32_t value)
+{
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+  return p + 4;
+}
+
+void Telemetry::Begin(Print &output, Print &logOutput, const char *const *names, uint8_t count)
+{
+  out = &output;
+  logOut = &logOutput;
+  widgetNames = names;
+  widgetCount = min<uint8_t>(count, TELEMETRY_MAX_WIDGETS);
+}
+
+void Telemetry::WatchTask(TaskHandle_t task)
+{
+  if (task != nullptr && taskCount < TELEMETRY_MAX_TASKS)
+  {
+    tasks[taskCount++] = task;
+  }
+}
+
+void Telemetry::WatchScheduler(HttpScheduler &watched)
+{
+  scheduler = &watched;
+}
+
+void Telemetry::WatchHttp(const HttpHostStats *stats, const char *const *names, uint8_t count)
+{
+  httpStats = stats;
+  httpNames = names;
+  httpCount = min<uint8_t>(count, TELEMETRY_MAX_HTTP);
+}
+
+void Telemetry::Command(const PlayerLinkFrame &frame)
+{
+  switch (frame.field)
+  {
+  case TELEMETRY_FIELD_DUMP:
+    Dump();
+    break;
+  case TELEMETRY_FIELD_STREAM:
+  {
+    uint32_t period = frame.type == LinkU32 ? PlayerLinkU32(frame) : SliceToInt(frame.payload);
+    periodMs = period == 0 ? 0 : max<uint32_t>(period, TELEMETRY_MIN_PERIOD_MS);
+    sampleMillis = millis();
+    for (uint8_t i = 0; i < widgetCount; i++)
+    {
+      widgets[i].microsMaxSample = 0;
+    }
+  }
+  break;
+  default:
+    break;
+  }
+}
+
+void Telemetry::WidgetTime(uint8_t widget, uint32_t micros)
+{
+  if (widget >= widgetCount)
+  {
+    return;
+  }
+
+  TelemetryWidgetStats &stats = widgets[widget];
+  stats.calls++;
+  stats.microsTotal += micros;
+  stats.microsMax = max(stats.microsMax, micros);
+  stats.microsMaxSample = max(stats.microsMaxSample, micros);
+}
+
+void Telemetry::Poll()
+{
+  if (periodMs == 0 || millis() - sampleMillis < periodMs)
+  {
+    return;
+  }
+
+  // keep the phase, but skip samples missed while the loop was busy
+  sampleMillis += periodMs * ((millis() - sampleMillis) / periodMs);
+  SendSample();
+}
+
+uint32_t Telemetry::NextSampleMs()
+{
+  if (periodMs == 0)
+  {
+    return UINT32_MAX;
+  }
+  uint32_t elapsed = millis() - sampleMillis;
+  return elapsed >= periodMs ? 0 : periodMs - elapsed;
+}
+
+void Telemetry::Dump()
+{
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t largestBlock = ESP.getMaxAllocHeap();
+  logOut->printf("[TELEM] Uptime %lu s, heap free %u B, largest block %u B (%u%% fragmented), min free %u B\n",
+              millis() / 1000, freeHeap, largestBlock, freeHeap ? 100 - largestBlock * 100 / freeHeap : 0,
+              ESP.getMinFreeHeap());
+
+  for (uint8_t i = 0; i < taskCount; i++)
+  {
+    logOut->printf("[TELEM] Stack %s %u B never used\n", pcTaskGetName(tasks[i]), uxTaskGetStackHighWaterMark(tasks[i]));
+  }
+  if (scheduler != nullptr)
+  {
+    HttpSchedulerStats stats = scheduler->Stats();
+    logOut->printf("[TELEM] HTTP jobs %u pending, %u submitted, %u coalesced, %u dropped, queued avg %u / max %u ms\n",
+                scheduler->Pending(), stats.submitted, stats.coalesced, stats.droppedFull,
+                stats.served ? stats.queuedMsTotal / stats.served : 0, stats.queuedMsMax);
+  }
+
+  for (uint8_t i = 0; i < httpCount; i++)
+  {
+    const HttpHostStats &stats = httpStats[i];
+    char histogram[HTTP_LATENCY_BUCKETS * 12];
+    int length = 0;
+    for (uint8_t bucket = 0; bucket < HTTP_LATENCY_BUCKETS; bucket++)
+    {
+      length += snprintf(histogram + length, sizeof(histogram) - length, " %lu:%u", 16UL << bucket, stats.latencyBuckets[bucket]);
+    }
+    logOut->printf("[TELEM] HTTP %s %u req, %u failed, p50 %u / p90 %u / p99 %u / max %u ms, <=ms:count%s\n",
+                httpNames[i], stats.requests, stats.failures, HttpLatencyPercentile(stats, 50),
+                HttpLatencyPercentile(stats, 90), HttpLatencyPercentile(stats, 99), stats.maxLatencyMs, histogram);
+  }
+
+  for (uint8_t i = 0; i < widgetCount; i++)
+  {
+    const TelemetryWidgetStats &stats = widgets[i];
+    logOut->printf("[TELEM] Widget %-16s %u calls, avg %u / max %u us\n", widgetNames[i], stats.calls,
+                stats.calls ? (uint32_t)(stats.microsTotal / stats.calls) : 0, stats.microsMax);
+  }
+}
+
+void Telemetry::SendSample()
+{
+  uint8_t payload[20 + TELEMETRY_MAX_TASKS * 4 + 1 + TELEMETRY_MAX_WIDGETS * 4];
+  uint8_t *p = payload;
+  *p++ = TELEMETRY_SAMPLE_VERSION;
+  p = PutU32(p, millis());
+  p = PutU32(p, ESP.getFreeHeap());
+  p = PutU32(p, ESP.getMaxAllocHeap());
+  p = PutU32(p, ESP.getMinFreeHeap());
+  *p++ = scheduler != nullptr ? scheduler->Pending() : 0;
+  *p++ = taskCount;
+  for (uint8_t i = 0; i < taskCount; i++)
+  {
+    p = PutU32(p, uxTaskGetStackHighWaterMark(tasks[i]));
+  }
+  *p++ = widgetCount;
+  for (uint8_t i = 0; i < widgetCount; i++)
+  {
+    p = PutU32(p, widgets[i].microsMaxSample);
+    widgets[i].microsMaxSample = 0;
+  }
+
+  PlayerLinkWrite(*out, TELEMETRY_SCREEN, TELEMETRY_FIELD_SAMPLE, LinkBytes, payload, p - payload);
+}
@@ -0,0 +1,246 @@
+#include "watchlist.h"
+
+static const char *const typePrefixes[] = {"si_", "se_", "sn_", "cu_"};
+
+struct WatchDefault
+{
+  WatchType type;
+  const char *symbol;
+  const char *name;
+};
+
+static const WatchDefault defaults[] = {
+    {WatchIndex, "t00", "加權指數"},
+    {WatchEtf, "0050", "元大台灣50"},
+    {WatchStock, "2330", "台積電"},
+    {WatchCurrency, "JPY", "日幣_台幣 JPY_TWD"},
+    {WatchCurrency, "USD", "美元_台幣 USD_TWD"},
+};
+
+void Watchlist::Reset()
+{
+  count = 0;
+  stockCount = 0;
+  poolUsed = 0;
+  for (const WatchDefault &entry : defaults)
+  {
+    Insert(entry.type, entry.symbol, strlen(entry.symbol), entry.name, strlen(entry.name));
+  }
+}
+
+bool Watchlist::Add(const char *entry, uint16_t length)
+{
+  if (length < 4 || entry[2] != '_')
+  {
+    return false;
+  }
+
+  uint8_t type = 0;
+  while (type <= WatchCurrency && strncmp(entry, typePrefixes[type], 3) != 0)
+    type++;
+  if (type > WatchCurrency)
+  {
+    return false;
+  }
+
+  const char *symbol = entry + 3;
+  const char *end = entry + length;
+  const char *comma = (const char *)memchr(symbol, ',', end - symbol);
+  uint8_t symbolLength = (comma != nullptr ? comma : end) - symbol;
+  const char *name = comma != nullptr ? comma + 1 : symbol; // no name, show the symbol
+  uint16_t nameLength = comma != nullptr ? end - name : symbolLength;
+  return Insert((WatchType)type, symbol, symbolLength, name, nameLength);
+}
+
+bool Watchlist::Insert(WatchType type, const char *symbol, uint8_t symbolLength, const char *name, uint16_t nameLength)
+{
+  while (nameLength > 0 && (name[nameLength - 1] == '\r' || name[nameLength - 1] == '\n'))
+    nameLength--;
+  if (symbolLength == 0 || symbolLength >= WATCHLIST_SYMBOL_SIZE || count >= WATCHLIST_MAX_SYMBOLS ||
+      poolUsed + nameLength + 1 > WATCHLIST_POOL_SIZE)
+  {
+    return false;
+  }
+
+  char padded[WATCHLIST_SYMBOL_SIZE] = {};
+  memcpy(padded, symbol, symbolLength);
+  if (Find(type, padded) >= 0)
+  {
+    return false;
+  }
+
+  // TWSE entries go to the end of the stock range, currencies to the end of the list
+  uint8_t index = type == WatchCurrency ? count : stockCount;
+  uint8_t moved = count - index;
+  memmove(types + index + 1, types + index, moved * sizeof(types[0]));
+  memmove(symbols + index + 1, symbols + index, moved * sizeof(symbols[0]));
+  memmove(nameOffsets + index + 1, nameOffsets + index, moved * sizeof(nameOffsets[0]));
+
+  types[index] = type;
+  memcpy(symbols[index], padded, WATCHLIST_SYMBOL_SIZE);
+  nameOffsets[index] = poolUsed;
+  memcpy(pool + poolUsed, name, nameLength);
+  pool[poolUsed + nameLength] = '\0';
+  poolUsed += nameLength + 1;
+
+  count++;
+  if (type != WatchCurrency)
+    stockCount++;
+  return true;
+}
+
+bool Watchlist::Remove(const char *symbol, uint16_t length)
+{
+  uint8_t index = 0;
+  while (index < count && !(strlen(symbols[index]) == length && strncmp(symbols[index], symbol, length) == 0))
+    index++;
+  if (index >= count)
+  {
+    return false;
+  }
+
+  // close the gap in the pool, names stored after this one move down
+  uint16_t offset = nameOffsets[index];
+  uint16_t nameSize = strlen(pool + offset) + 1;
+  memmove(pool + offset, pool + offset + nameSize, poolUsed - offset - nameSize);
+  poolUsed -= nameSize;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (nameOffsets[i] > offset)
+      nameOffsets[i] -= nameSize;
+  }
+
+  if (types[index] != WatchCurrency)
+    stockCount--;
+  uint8_t moved = count - index - 1;
+  memmove(types + index, types + index + 1, moved * sizeof(types[0]));
+  memmove(symbols + index, symbols + index + 1, moved * sizeof(symbols[0]));
+  memmove(nameOffsets + index, nameOffsets + index + 1, moved * sizeof(nameOffsets[0]));
+  count--;
+  return true;
+}
+
+int16_t Watchlist::Find(WatchType type, const char *symbol) const
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (types[i] == type && strncmp(symbols[i], symbol, WATCHLIST_SYMBOL_SIZE) == 0)
+      return i;
+  }
+  return -1;
+}
+
+uint8_t Watchlist::Count() const
+{
+  return count;
+}
+
+uint8_t Watchlist::StockCount() const
+{
+  return stockCount;
+}
+
+WatchType Watchlist::Type(uint8_t index) const
+{
+  return types[index];
+}
+
+const char *Watchlist::Symbol(uint8_t index) const
+{
+  return symbols[index];
+}
+
+const char *Watchlist::Name(uint8_t index) const
+{
+  return pool + nameOffsets[index];
+}
+
+const char *Watchlist::TypeLabel(uint8_t index) const
+{
+  switch (types[index])
+  {
+  case WatchIndex:
+    return "INDEX ";
+  case WatchEtf:
+    return "ETF ";
+  default:
+    return "";
+  }
+}
+
+uint16_t Watchlist::PoolUsed() const
+{
+  return poolUsed;
+}
+
+// blob: [version][count][stockCount][0][poolUsed u16] types[count] symbols[count] nameOffsets[count] pool[poolUsed]
+bool Watchlist::Save(Preferences &prefs, const char *key) const
+{
+  uint8_t blob[WATCHLIST_BLOB_MAX];
+  uint8_t *p = blob;
+  *p++ = WATCHLIST_BLOB_VERSION;
+  *p++ = count;
+  *p++ = stockCount;
+  *p++ = 0;
+  memcpy(p, &poolUsed, 2);
+  p += 2;
+  memcpy(p, types, count * sizeof(types[0]));
+  p += count * sizeof(types[0]);
+  memcpy(p, symbols, count * sizeof(symbols[0]));
+  p += count * sizeof(symbols[0]);
+  memcpy(p, nameOffsets, count * sizeof(nameOffsets[0]));
+  p += count * sizeof(nameOffsets[0]);
+  memcpy(p, pool, poolUsed);
+  p += poolUsed;
+
+  size_t size = p - blob;
+  return prefs.putBytes(key, blob, size) == size;
+}
+
+// a blob that does not check out leaves the list untouched
+bool Watchlist::Load(Preferences &prefs, const char *key)
+{
+  uint8_t blob[WATCHLIST_BLOB_MAX];
+  size_t size = prefs.getBytesLength(key);
+  if (size < WATCHLIST_BLOB_HEADER || size > sizeof(blob) || prefs.getBytes(key, blob, sizeof(blob)) != size)
+  {
+    return false;
+  }
+
+  uint8_t newCount = blob[1];
+  uint8_t newStockCount = blob[2];
+  uint16_t newPoolUsed;
+  memcpy(&newPoolUsed, blob + 4, 2);
+  if (blob[0] != WATCHLIST_BLOB_VERSION || newCount > WATCHLIST_MAX_SYMBOLS || newStockCount > newCount ||
+      newPoolUsed > WATCHLIST_POOL_SIZE ||
+      size != (size_t)(WATCHLIST_BLOB_HEADER + newCount * (1 + WATCHLIST_SYMBOL_SIZE + 2) + newPoolUsed) ||
+      (newPoolUsed > 0 && blob[size - 1] != '\0'))
+  {
+    return false;
+  }
+
+  const uint8_t *p = blob + WATCHLIST_BLOB_HEADER;
+  const uint8_t *newTypes = p;
+  const uint8_t *newSymbols = newTypes + newCount;
+  const uint8_t *newOffsets = newSymbols + newCount * WATCHLIST_SYMBOL_SIZE;
+  for (uint8_t i = 0; i < newCount; i++)
+  {
+    uint16_t offset;
+    memcpy(&offset, newOffsets + i * 2, 2);
+    bool isStock = newTypes[i] != WatchCurrency;
+    if (newTypes[i] > WatchCurrency || isStock != (i < newStockCount) || offset >= newPoolUsed ||
+        newSymbols[i * WATCHLIST_SYMBOL_SIZE + WATCHLIST_SYMBOL_SIZE - 1] != '\0')
+    {
+      return false;
+    }
+  }
+
+  count = newCount;
+  stockCount = newStockCount;
+  poolUsed = newPoolUsed;
+  memcpy(types, newTypes, count);
+  memcpy(symbols, newSymbols, count * WATCHLIST_SYMBOL_SIZE);
+  memcpy(nameOffsets, newOffsets, count * 2);
+  memcpy(pool, newOffsets + count * 2, poolUsed);
+  return true;
+}